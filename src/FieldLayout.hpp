@@ -0,0 +1,92 @@
+/*
+ *  Copyright 2019-2024 Diligent Graphics LLC
+ *  Copyright 2015-2019 Egor Yusov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  In no event and under no legal theory, whether in tort (including negligence),
+ *  contract, or otherwise, unless required by applicable law (such as deliberate
+ *  and grossly negligent acts) or agreed to in writing, shall any Contributor be
+ *  liable for any damages, including any direct, indirect, special, incidental,
+ *  or consequential damages of any character arising as a result of this License or
+ *  out of the use or inability to use the software (including but not limited to damages
+ *  for loss of goodwill, work stoppage, computer failure or malfunction, or any and
+ *  all other commercial damages or losses), even if such Contributor has been advised
+ *  of the possibility of such damages.
+ */
+
+#pragma once
+
+#include "BasicMath.hpp"
+#include "ShaderMacroHelper.hpp"
+
+namespace Diligent
+{
+
+// Storage layout of the simulation fields. Must match FIELD_LAYOUT in field_layout.fxh.
+enum FIELD_LAYOUT : Uint32
+{
+    FIELD_LAYOUT_TEXTURE = 0,   // 3D textures
+    FIELD_LAYOUT_BUFFER_LINEAR, // Structured buffers, SoA planes, linear index
+    FIELD_LAYOUT_BUFFER_MORTON, // Structured buffers, SoA planes, 8x8 Morton tiles per z plane
+    FIELD_LAYOUT_COUNT
+};
+
+inline const char* GetFieldLayoutName(FIELD_LAYOUT Layout)
+{
+    switch (Layout)
+    {
+        case FIELD_LAYOUT_TEXTURE: return "Texture3D";
+        case FIELD_LAYOUT_BUFFER_LINEAR: return "SoA Linear";
+        case FIELD_LAYOUT_BUFFER_MORTON: return "SoA Morton";
+        default: return "Unknown";
+    }
+}
+
+// Number of elements in one SoA plane, including the padding of the Morton tiles
+inline Uint32 GetFieldPlaneSize(FIELD_LAYOUT Layout, const int3& GridSize)
+{
+    if (Layout == FIELD_LAYOUT_BUFFER_MORTON)
+        return ((GridSize.x + 7) / 8) * ((GridSize.y + 7) / 8) * 64 * GridSize.z;
+    return GridSize.x * GridSize.y * GridSize.z;
+}
+
+// CPU mirror of FieldIndex() in field_layout.fxh, so that tools can read and write buffer fields
+inline Uint32 GetFieldIndex(FIELD_LAYOUT Layout, const int3& GridSize, const int3& Cell)
+{
+    if (Layout == FIELD_LAYOUT_BUFFER_MORTON)
+    {
+        auto SpreadBits3 = [](Uint32 v) {
+            v &= 7u;
+            v = (v | (v << 2)) & 0x13u;
+            v = (v | (v << 1)) & 0x15u;
+            return v;
+        };
+        const Uint32 TilesX = (GridSize.x + 7) / 8;
+        const Uint32 TilesY = (GridSize.y + 7) / 8;
+        const Uint32 Tile   = (Cell.z * TilesY + (Cell.y >> 3)) * TilesX + (Cell.x >> 3);
+        return Tile * 64 + (SpreadBits3(Cell.x) | (SpreadBits3(Cell.y) << 1));
+    }
+    return (Cell.z * GridSize.y + Cell.y) * GridSize.x + Cell.x;
+}
+
+// Macros expected by field_layout.fxh
+inline void AddFieldLayoutMacros(ShaderMacroHelper& Macros, FIELD_LAYOUT Layout, const int3& GridSize)
+{
+    Macros.AddShaderMacro("FIELD_LAYOUT", static_cast<int>(Layout));
+    Macros.AddShaderMacro("GRID_SIZE_X", GridSize.x);
+    Macros.AddShaderMacro("GRID_SIZE_Y", GridSize.y);
+    Macros.AddShaderMacro("GRID_SIZE_Z", GridSize.z);
+}
+
+} // namespace Diligent
@@ -0,0 +1,132 @@
+/*
+ *  Copyright 2019-2024 Diligent Graphics LLC
+ *  Copyright 2015-2019 Egor Yusov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  In no event and under no legal theory, whether in tort (including negligence),
+ *  contract, or otherwise, unless required by applicable law (such as deliberate
+ *  and grossly negligent acts) or agreed to in writing, shall any Contributor be
+ *  liable for any damages, including any direct, indirect, special, incidental,
+ *  or consequential damages of any character arising as a result of this License or
+ *  out of the use or inability to use the software (including but not limited to damages
+ *  for loss of goodwill, work stoppage, computer failure or malfunction, or any and
+ *  all other commercial damages or losses), even if such Contributor has been advised
+ *  of the possibility of such damages.
+ */
+
+#include "FluidKernels.hpp"
+
+#include <vector>
+
+#include "GraphicsUtilities.h"
+#include "FluidConstants.hpp"
+
+namespace Diligent
+{
+
+RefCntAutoPtr<IPipelineState> CreateFluidKernel(IRenderDevice*                   pDevice,
+                                                IShaderSourceInputStreamFactory* pShaderFactory,
+                                                const char*                      FilePath,
+                                                const ShaderMacroHelper&         Macros)
+{
+    ShaderCreateInfo shaderCI;
+    shaderCI.SourceLanguage                  = SHADER_SOURCE_LANGUAGE_HLSL;
+    shaderCI.Desc.UseCombinedTextureSamplers = false;
+    shaderCI.Desc.ShaderType                 = SHADER_TYPE_COMPUTE;
+    shaderCI.Desc.Name                       = FilePath;
+    shaderCI.EntryPoint                      = "main";
+    shaderCI.FilePath                        = FilePath;
+    shaderCI.pShaderSourceStreamFactory      = pShaderFactory;
+    shaderCI.Macros                          = Macros;
+
+    RefCntAutoPtr<IShader> pCS;
+    pDevice->CreateShader(shaderCI, &pCS);
+
+    RefCntAutoPtr<IPipelineState> pPSO;
+    if (!pCS)
+        return pPSO;
+
+    ComputePipelineStateCreateInfo psoCI;
+    psoCI.PSODesc.PipelineType                       = PIPELINE_TYPE_COMPUTE;
+    psoCI.PSODesc.ResourceLayout.DefaultVariableType = SHADER_RESOURCE_VARIABLE_TYPE_MUTABLE;
+    psoCI.PSODesc.Name                               = FilePath;
+    psoCI.pCS                                        = pCS;
+    pDevice->CreateComputePipelineState(psoCI, &pPSO);
+
+    return pPSO;
+}
+
+RefCntAutoPtr<ITexture> CreateEmptyObstacleMask(IRenderDevice* pDevice, const int3& GridSize, const char* Name)
+{
+    // 32 cells along X per texel, as in obstacles.fxh
+    TextureDesc texDesc;
+    texDesc.Name      = Name;
+    texDesc.Type      = RESOURCE_DIM_TEX_3D;
+    texDesc.Width     = (GridSize.x + 31) / 32;
+    texDesc.Height    = GridSize.y;
+    texDesc.Depth     = GridSize.z;
+    texDesc.MipLevels = 1;
+    texDesc.Usage     = USAGE_IMMUTABLE;
+    texDesc.BindFlags = BIND_SHADER_RESOURCE;
+    texDesc.Format    = TEX_FORMAT_R32_UINT;
+
+    std::vector<Uint32> maskData(texDesc.Width * texDesc.Height * texDesc.Depth, 0);
+    TextureSubResData   subresData;
+    subresData.pData       = maskData.data();
+    subresData.Stride      = sizeof(Uint32) * texDesc.Width;
+    subresData.DepthStride = sizeof(Uint32) * texDesc.Width * texDesc.Height;
+
+    TextureData initData;
+    initData.pSubResources   = &subresData;
+    initData.NumSubresources = 1;
+
+    RefCntAutoPtr<ITexture> pMask;
+    pDevice->CreateTexture(texDesc, &initData, &pMask);
+    return pMask;
+}
+
+RefCntAutoPtr<IBuffer> CreateNoObstacleConstants(IRenderDevice* pDevice, const char* Name)
+{
+    ObstacleConstantsStruct obstacleConstants = {};
+
+    RefCntAutoPtr<IBuffer> pCB;
+    CreateUniformBuffer(pDevice, sizeof(obstacleConstants), Name, &pCB, USAGE_IMMUTABLE, BIND_UNIFORM_BUFFER, CPU_ACCESS_NONE, &obstacleConstants);
+    return pCB;
+}
+
+RefCntAutoPtr<IShaderResourceBinding> CreateFluidSRB(IPipelineState* pPSO, const FluidSharedResources& Shared, FluidBindings Bindings)
+{
+    RefCntAutoPtr<IShaderResourceBinding> pSRB;
+    pPSO->CreateShaderResourceBinding(&pSRB, true);
+    if (!pSRB)
+        return pSRB;
+
+    auto Bind = [&](const char* Name, IDeviceObject* pObject) {
+        if (pObject == nullptr)
+            return;
+        if (auto* var = pSRB->GetVariableByName(SHADER_TYPE_COMPUTE, Name))
+            var->Set(pObject);
+    };
+
+    for (const auto& binding : Bindings)
+        Bind(binding.first, binding.second);
+
+    Bind("ObstacleMask", Shared.pObstacleMask != nullptr ? Shared.pObstacleMask->GetDefaultView(TEXTURE_VIEW_SHADER_RESOURCE) : nullptr);
+    Bind("ObstacleConstants", Shared.pObstacleConstants);
+    Bind("Constants", Shared.pConstants);
+    Bind("SlabPass", Shared.pSlabPass);
+    return pSRB;
+}
+
+} // namespace Diligent
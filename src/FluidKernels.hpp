@@ -0,0 +1,70 @@
+/*
+ *  Copyright 2019-2024 Diligent Graphics LLC
+ *  Copyright 2015-2019 Egor Yusov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  In no event and under no legal theory, whether in tort (including negligence),
+ *  contract, or otherwise, unless required by applicable law (such as deliberate
+ *  and grossly negligent acts) or agreed to in writing, shall any Contributor be
+ *  liable for any damages, including any direct, indirect, special, incidental,
+ *  or consequential damages of any character arising as a result of this License or
+ *  out of the use or inability to use the software (including but not limited to damages
+ *  for loss of goodwill, work stoppage, computer failure or malfunction, or any and
+ *  all other commercial damages or losses), even if such Contributor has been advised
+ *  of the possibility of such damages.
+ */
+
+#pragma once
+
+#include <initializer_list>
+#include <utility>
+
+#include "RenderDevice.h"
+#include "RefCntAutoPtr.hpp"
+#include "BasicMath.hpp"
+#include "ShaderMacroHelper.hpp"
+
+namespace Diligent
+{
+
+// Setup shared by the tools that run the fluid kernels on their own resources
+// (LayoutBenchmark, SlabVerification).
+
+// Compiles one of the kernels (advect.csh, jacobi.csh...) into a compute pipeline with mutable variables
+RefCntAutoPtr<IPipelineState> CreateFluidKernel(IRenderDevice*                   pDevice,
+                                                IShaderSourceInputStreamFactory* pShaderFactory,
+                                                const char*                      FilePath,
+                                                const ShaderMacroHelper&         Macros);
+
+// Obstacle mask without solid cells for a grid of the given size
+RefCntAutoPtr<ITexture> CreateEmptyObstacleMask(IRenderDevice* pDevice, const int3& GridSize, const char* Name);
+
+// ObstacleConstants with the moving obstacle disabled
+RefCntAutoPtr<IBuffer> CreateNoObstacleConstants(IRenderDevice* pDevice, const char* Name);
+
+// Resources that every kernel of a run binds under the same name; null ones are skipped
+struct FluidSharedResources
+{
+    ITexture* pObstacleMask      = nullptr;
+    IBuffer*  pObstacleConstants = nullptr;
+    IBuffer*  pConstants         = nullptr;
+    IBuffer*  pSlabPass          = nullptr;
+};
+
+using FluidBindings = std::initializer_list<std::pair<const char*, IDeviceObject*>>;
+
+// Creates a binding with the kernel's own resources, by variable name, plus the shared ones it declares
+RefCntAutoPtr<IShaderResourceBinding> CreateFluidSRB(IPipelineState* pPSO, const FluidSharedResources& Shared, FluidBindings Bindings);
+
+} // namespace Diligent
@@ -0,0 +1,180 @@
+/*
+ *  Copyright 2019-2024 Diligent Graphics LLC
+ *  Copyright 2015-2019 Egor Yusov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  In no event and under no legal theory, whether in tort (including negligence),
+ *  contract, or otherwise, unless required by applicable law (such as deliberate
+ *  and grossly negligent acts) or agreed to in writing, shall any Contributor be
+ *  liable for any damages, including any direct, indirect, special, incidental,
+ *  or consequential damages of any character arising as a result of this License or
+ *  out of the use or inability to use the software (including but not limited to damages
+ *  for loss of goodwill, work stoppage, computer failure or malfunction, or any and
+ *  all other commercial damages or losses), even if such Contributor has been advised
+ *  of the possibility of such damages.
+ */
+
+#include "FrameTracer.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+namespace Diligent
+{
+
+namespace
+{
+
+void WriteJsonString(std::ofstream& Stream, const char* Str)
+{
+    Stream << '"';
+    for (const char* c = Str != nullptr ? Str : ""; *c != '\0'; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+            Stream << '\\';
+        Stream << *c;
+    }
+    Stream << '"';
+}
+
+// Nanoseconds as microseconds with three decimals. Integer formatting keeps full precision,
+// whereas the default stream precision of 6 digits loses microseconds after a few seconds of uptime.
+void WriteMicroseconds(std::ofstream& Stream, Uint64 Ns)
+{
+    Stream << Ns / 1000 << '.'
+           << static_cast<char>('0' + Ns / 100 % 10)
+           << static_cast<char>('0' + Ns / 10 % 10)
+           << static_cast<char>('0' + Ns % 10);
+}
+
+} // namespace
+
+FrameTracer& FrameTracer::Get()
+{
+    static FrameTracer Tracer;
+    return Tracer;
+}
+
+FrameTracer::FrameTracer() :
+    m_Origin{std::chrono::steady_clock::now()}
+{
+    constexpr Uint32 NumCalibrationReads = 1000;
+
+    const Uint64 StartNs = Now();
+    for (Uint32 i = 0; i < NumCalibrationReads; ++i)
+        Now();
+    m_ClockCostNs = (Now() - StartNs) / NumCalibrationReads;
+}
+
+Uint64 FrameTracer::Now() const
+{
+    return static_cast<Uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_Origin).count());
+}
+
+FrameTracer::ThreadBuffer& FrameTracer::GetThreadBuffer()
+{
+    thread_local ThreadBuffer* pBuffer = nullptr;
+    if (pBuffer == nullptr)
+    {
+        std::lock_guard<std::mutex> Lock{m_BuffersMtx};
+        m_Buffers.emplace_back(new ThreadBuffer);
+        pBuffer           = m_Buffers.back().get();
+        pBuffer->ThreadId = static_cast<Uint32>(m_Buffers.size());
+    }
+    return *pBuffer;
+}
+
+void FrameTracer::Record(const char* Name, Uint64 StartNs, Uint64 EndNs, bool StallCandidate)
+{
+    ThreadBuffer& Buffer = GetThreadBuffer();
+
+    // Only the owning thread writes to the buffer, so a relaxed load of its own counter is enough
+    const Uint64 Index = Buffer.Count.load(std::memory_order_relaxed);
+    Event&       Evt   = Buffer.Events[Index % EventsPerThread];
+    Evt.Name           = Name;
+    Evt.StartNs        = StartNs;
+    Evt.DurNs          = EndNs - StartNs;
+    Evt.Stall          = StallCandidate && Evt.DurNs > m_StallThresholdNs.load(std::memory_order_relaxed);
+    Buffer.Count.store(Index + 1, std::memory_order_release);
+
+    if (Evt.Stall)
+    {
+        m_StallCount.fetch_add(1, std::memory_order_relaxed);
+        m_LastStallName.store(Name, std::memory_order_relaxed);
+    }
+}
+
+void FrameTracer::BeginFrame()
+{
+    const Uint64 NowNs = Now();
+    if (m_FrameStartNs != 0)
+    {
+        m_LastFrameMs = static_cast<float>(NowNs - m_FrameStartNs) * 1e-6f;
+
+        const Uint32 Bin = std::min(static_cast<Uint32>(m_LastFrameMs / HistogramBinMs), NumHistogramBins - 1);
+        m_Histogram[Bin] += 1;
+    }
+    m_LastOverheadMs = static_cast<float>(m_FrameOverheadNs.exchange(0, std::memory_order_relaxed)) * 1e-6f;
+    m_FrameStartNs   = NowNs;
+}
+
+void FrameTracer::ResetStatistics()
+{
+    std::fill(std::begin(m_Histogram), std::end(m_Histogram), 0.f);
+    m_StallCount.store(0, std::memory_order_relaxed);
+    m_LastStallName.store(nullptr, std::memory_order_relaxed);
+}
+
+bool FrameTracer::ExportChromeTrace(const char* FilePath) const
+{
+    std::ofstream Stream{FilePath};
+    if (!Stream)
+        return false;
+
+    Stream << "{\"traceEvents\":[\n";
+
+    bool First = true;
+
+    std::lock_guard<std::mutex> Lock{m_BuffersMtx};
+    for (const auto& pBuffer : m_Buffers)
+    {
+        const Uint64 Count = pBuffer->Count.load(std::memory_order_acquire);
+        const Uint64 Begin = Count > EventsPerThread ? Count - EventsPerThread : 0;
+        for (Uint64 i = Begin; i < Count; ++i)
+        {
+            const Event& Evt = pBuffer->Events[i % EventsPerThread];
+
+            if (!First)
+                Stream << ",\n";
+            First = false;
+
+            // Complete ("X") events with timestamps in microseconds
+            Stream << "{\"name\":";
+            WriteJsonString(Stream, Evt.Name);
+            Stream << ",\"cat\":\"" << (Evt.Stall ? "stall" : "cpu") << "\",\"ph\":\"X\",\"ts\":";
+            WriteMicroseconds(Stream, Evt.StartNs);
+            Stream << ",\"dur\":";
+            WriteMicroseconds(Stream, Evt.DurNs);
+            Stream << ",\"pid\":1,\"tid\":" << pBuffer->ThreadId;
+            if (Evt.Stall)
+                Stream << ",\"args\":{\"stall\":true}";
+            Stream << "}";
+        }
+    }
+
+    Stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return Stream.good();
+}
+
+} // namespace Diligent
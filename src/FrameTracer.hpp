@@ -0,0 +1,189 @@
+/*
+ *  Copyright 2019-2024 Diligent Graphics LLC
+ *  Copyright 2015-2019 Egor Yusov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  In no event and under no legal theory, whether in tort (including negligence),
+ *  contract, or otherwise, unless required by applicable law (such as deliberate
+ *  and grossly negligent acts) or agreed to in writing, shall any Contributor be
+ *  liable for any damages, including any direct, indirect, special, incidental,
+ *  or consequential damages of any character arising as a result of this License or
+ *  out of the use or inability to use the software (including but not limited to damages
+ *  for loss of goodwill, work stoppage, computer failure or malfunction, or any and
+ *  all other commercial damages or losses), even if such Contributor has been advised
+ *  of the possibility of such damages.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "BasicTypes.h"
+
+// Set to 0 (CMake option FLUID_ENABLE_TRACING=OFF) to compile every trace scope out of the sample
+#ifndef FLUID_ENABLE_TRACING
+#    define FLUID_ENABLE_TRACING 1
+#endif
+
+namespace Diligent
+{
+
+// Lightweight CPU tracer. Every thread records into its own fixed-size ring of
+// events, so the hot path is two clock reads and a store without any locks.
+// Events are exported on demand in the Chrome trace format (chrome://tracing).
+class FrameTracer
+{
+public:
+    struct Event
+    {
+        const char* Name    = nullptr; // Must be a string literal or otherwise outlive the tracer
+        Uint64      StartNs = 0;
+        Uint64      DurNs   = 0;
+        bool        Stall   = false;
+    };
+
+    static constexpr Uint32 EventsPerThread  = 1 << 16;
+    static constexpr Uint32 NumHistogramBins = 34; // 1 ms bins, the last one collects everything above
+    static constexpr float  HistogramBinMs   = 1.0f;
+
+    static FrameTracer& Get();
+
+    void SetEnabled(bool Enabled) { m_Enabled.store(Enabled, std::memory_order_relaxed); }
+    bool IsEnabled() const { return m_Enabled.load(std::memory_order_relaxed); }
+
+    // Scopes flagged as stall candidates that run longer than this are marked as stalls
+    void  SetStallThresholdMs(float ThresholdMs) { m_StallThresholdNs.store(static_cast<Uint64>(ThresholdMs * 1e6f), std::memory_order_relaxed); }
+    float GetStallThresholdMs() const { return static_cast<float>(m_StallThresholdNs.load(std::memory_order_relaxed)) * 1e-6f; }
+
+    Uint64 Now() const;
+
+    void Record(const char* Name, Uint64 StartNs, Uint64 EndNs, bool StallCandidate);
+
+    // Time a scope spent in the tracer itself, i.e. in Record() and the clock reads
+    void AddOverhead(Uint64 Ns) { m_FrameOverheadNs.fetch_add(Ns, std::memory_order_relaxed); }
+
+    // Estimated cost of one Now() call, measured when the tracer is created
+    Uint64 GetClockCostNs() const { return m_ClockCostNs; }
+
+    // Marks the start of a new frame and adds the previous frame duration to the histogram
+    void BeginFrame();
+
+    const float* GetHistogram() const { return m_Histogram; }
+    float        GetLastFrameMs() const { return m_LastFrameMs; }
+    float        GetLastOverheadMs() const { return m_LastOverheadMs; }
+    Uint32       GetStallCount() const { return m_StallCount.load(std::memory_order_relaxed); }
+    const char*  GetLastStallName() const { return m_LastStallName.load(std::memory_order_relaxed); }
+    void         ResetStatistics();
+
+    // Writes all buffered events to a Chrome trace JSON file. Must be called while no
+    // other thread is recording, e.g. between frames on the main thread.
+    bool ExportChromeTrace(const char* FilePath) const;
+
+private:
+    struct ThreadBuffer
+    {
+        std::vector<Event>  Events = std::vector<Event>(EventsPerThread);
+        std::atomic<Uint64> Count{0};
+        Uint32              ThreadId = 0;
+    };
+
+    FrameTracer();
+
+    ThreadBuffer& GetThreadBuffer();
+
+    std::atomic<bool>        m_Enabled{true};
+    std::atomic<Uint64>      m_StallThresholdNs{2000000};
+    std::atomic<Uint32>      m_StallCount{0};
+    std::atomic<const char*> m_LastStallName{nullptr};
+
+    const std::chrono::steady_clock::time_point m_Origin;
+
+    Uint64              m_ClockCostNs = 0;
+    std::atomic<Uint64> m_FrameOverheadNs{0};
+
+    Uint64 m_FrameStartNs   = 0;
+    float  m_LastFrameMs    = 0;
+    float  m_LastOverheadMs = 0;
+    float  m_Histogram[NumHistogramBins] = {};
+
+    // Only taken when a thread records its first event and during export
+    mutable std::mutex                         m_BuffersMtx;
+    std::vector<std::unique_ptr<ThreadBuffer>> m_Buffers;
+};
+
+class ScopedTrace
+{
+public:
+    ScopedTrace(const char* Name, bool StallCandidate) :
+        m_Name{Name},
+        m_StallCandidate{StallCandidate},
+        m_Active{FrameTracer::Get().IsEnabled()},
+        m_StartNs{m_Active ? FrameTracer::Get().Now() : 0}
+    {
+    }
+
+    ~ScopedTrace()
+    {
+        if (m_Active)
+        {
+            FrameTracer& Tracer = FrameTracer::Get();
+
+            const Uint64 EndNs = Tracer.Now();
+            Tracer.Record(m_Name, m_StartNs, EndNs, m_StallCandidate);
+            // The opening clock read and the latency of this last one fall outside the measured
+            // interval, so they are added as an estimate
+            Tracer.AddOverhead(Tracer.Now() - EndNs + 2 * Tracer.GetClockCostNs());
+        }
+    }
+
+    ScopedTrace(const ScopedTrace&) = delete;
+    ScopedTrace& operator=(const ScopedTrace&) = delete;
+
+private:
+    const char* const m_Name;
+    const bool        m_StallCandidate;
+    const bool        m_Active;
+    const Uint64      m_StartNs;
+};
+
+} // namespace Diligent
+
+#define FLUID_TRACE_CONCAT_IMPL(a, b) a##b
+#define FLUID_TRACE_CONCAT(a, b)      FLUID_TRACE_CONCAT_IMPL(a, b)
+
+#if FLUID_ENABLE_TRACING
+// Traces the enclosing scope
+#    define FLUID_TRACE_SCOPE(Name) ::Diligent::ScopedTrace FLUID_TRACE_CONCAT(_FluidTrace, __LINE__)(Name, false)
+// Traces the enclosing scope and flags it as a stall when it exceeds the threshold
+#    define FLUID_TRACE_STALL_SCOPE(Name) ::Diligent::ScopedTrace FLUID_TRACE_CONCAT(_FluidTrace, __LINE__)(Name, true)
+// Traces a single call (map, commit...) as a stall candidate
+#    define FLUID_TRACE_STALL_CALL(Name, ...) \
+        do                                    \
+        {                                     \
+            FLUID_TRACE_STALL_SCOPE(Name);    \
+            __VA_ARGS__;                      \
+        } while (false)
+#else
+#    define FLUID_TRACE_SCOPE(Name)
+#    define FLUID_TRACE_STALL_SCOPE(Name)
+#    define FLUID_TRACE_STALL_CALL(Name, ...) \
+        do                                    \
+        {                                     \
+            __VA_ARGS__;                      \
+        } while (false)
+#endif
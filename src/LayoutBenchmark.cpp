@@ -0,0 +1,341 @@
+/*
+ *  Copyright 2019-2024 Diligent Graphics LLC
+ *  Copyright 2015-2019 Egor Yusov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  In no event and under no legal theory, whether in tort (including negligence),
+ *  contract, or otherwise, unless required by applicable law (such as deliberate
+ *  and grossly negligent acts) or agreed to in writing, shall any Contributor be
+ *  liable for any damages, including any direct, indirect, special, incidental,
+ *  or consequential damages of any character arising as a result of this License or
+ *  out of the use or inability to use the software (including but not limited to damages
+ *  for loss of goodwill, work stoppage, computer failure or malfunction, or any and
+ *  all other commercial damages or losses), even if such Contributor has been advised
+ *  of the possibility of such damages.
+ */
+
+#include "LayoutBenchmark.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <initializer_list>
+#include <utility>
+
+#include "Errors.hpp"
+#include "MapHelper.hpp"
+#include "GraphicsUtilities.h"
+#include "FluidConstants.hpp"
+#include "FluidKernels.hpp"
+
+namespace Diligent
+{
+
+LayoutBenchmark::LayoutBenchmark(IRenderDevice* pDevice, IDeviceContext* pContext, IEngineFactory* pEngineFactory) :
+    m_pDevice{pDevice},
+    m_pContext{pContext}
+{
+    pEngineFactory->CreateDefaultShaderSourceStreamFactory(nullptr, &m_pShaderFactory);
+
+    SamplerDesc SamDesc;
+    SamDesc.MinFilter = FILTER_TYPE_LINEAR;
+    SamDesc.MagFilter = FILTER_TYPE_LINEAR;
+    SamDesc.MipFilter = FILTER_TYPE_LINEAR;
+    m_pDevice->CreateSampler(SamDesc, &m_pLinearSampler);
+}
+
+LayoutBenchmark::Field LayoutBenchmark::CreateField(FIELD_LAYOUT Layout, const int3& GridSize, bool IsVelocity, const char* Name)
+{
+    Field field;
+
+    if (Layout == FIELD_LAYOUT_TEXTURE)
+    {
+        TextureDesc texDesc;
+        texDesc.Name      = Name;
+        texDesc.Type      = RESOURCE_DIM_TEX_3D;
+        texDesc.Width     = GridSize.x;
+        texDesc.Height    = GridSize.y;
+        texDesc.Depth     = GridSize.z;
+        texDesc.MipLevels = 1;
+        texDesc.Usage     = USAGE_DEFAULT;
+        texDesc.BindFlags = BIND_SHADER_RESOURCE | BIND_UNORDERED_ACCESS;
+        texDesc.Format    = IsVelocity ? TEX_FORMAT_RGBA32_FLOAT : TEX_FORMAT_R32_FLOAT;
+
+        // Fields start at zero: pressure is read by the first jacobi iteration
+        const Uint32       texelSize = IsVelocity ? sizeof(float4) : sizeof(float);
+        std::vector<Uint8> zeroData(static_cast<size_t>(texelSize) * GridSize.x * GridSize.y * GridSize.z, 0);
+
+        TextureSubResData subresData;
+        subresData.pData       = zeroData.data();
+        subresData.Stride      = texelSize * GridSize.x;
+        subresData.DepthStride = texelSize * GridSize.x * GridSize.y;
+
+        TextureData initData;
+        initData.pSubResources   = &subresData;
+        initData.NumSubresources = 1;
+
+        RefCntAutoPtr<ITexture> pTex;
+        m_pDevice->CreateTexture(texDesc, &initData, &pTex);
+        if (!pTex)
+            return field;
+
+        field.pSRV      = pTex->GetDefaultView(TEXTURE_VIEW_SHADER_RESOURCE);
+        field.pUAV      = pTex->GetDefaultView(TEXTURE_VIEW_UNORDERED_ACCESS);
+        field.pResource = pTex;
+    }
+    else
+    {
+        // Velocity stores its three components as consecutive SoA planes
+        const Uint32 numElements = GetFieldPlaneSize(Layout, GridSize) * (IsVelocity ? 3 : 1);
+
+        BufferDesc buffDesc;
+        buffDesc.Name              = Name;
+        buffDesc.Size              = numElements * sizeof(float);
+        buffDesc.Usage             = USAGE_DEFAULT;
+        buffDesc.BindFlags         = BIND_SHADER_RESOURCE | BIND_UNORDERED_ACCESS;
+        buffDesc.Mode              = BUFFER_MODE_STRUCTURED;
+        buffDesc.ElementByteStride = sizeof(float);
+
+        std::vector<float> zeroData(numElements, 0.f);
+        BufferData         initData{zeroData.data(), buffDesc.Size};
+
+        RefCntAutoPtr<IBuffer> pBuff;
+        m_pDevice->CreateBuffer(buffDesc, &initData, &pBuff);
+        if (!pBuff)
+            return field;
+
+        field.pSRV      = pBuff->GetDefaultView(BUFFER_VIEW_SHADER_RESOURCE);
+        field.pUAV      = pBuff->GetDefaultView(BUFFER_VIEW_UNORDERED_ACCESS);
+        field.pResource = pBuff;
+    }
+
+    return field;
+}
+
+RefCntAutoPtr<IPipelineState> LayoutBenchmark::CreateKernel(const char* FilePath, FIELD_LAYOUT Layout, bool EmulatedFilter, const int3& GridSize)
+{
+    ShaderMacroHelper Macros;
+    AddFieldLayoutMacros(Macros, Layout, GridSize);
+    if (EmulatedFilter)
+        Macros.AddShaderMacro("EMULATED_VELOCITY_SAMPLER", 1);
+
+    return CreateFluidKernel(m_pDevice, m_pShaderFactory, FilePath, Macros);
+}
+
+double LayoutBenchmark::RunConfig(FIELD_LAYOUT Layout, bool EmulatedFilter, const int3& GridSize)
+{
+    const Uint32 NumSteps            = m_NumSteps;
+    const Uint32 NumJacobiIterations = m_NumJacobiIterations;
+
+    Field velocity[2] = {
+        CreateField(Layout, GridSize, true, "Benchmark Velocity 0"),
+        CreateField(Layout, GridSize, true, "Benchmark Velocity 1")};
+    Field pressure[2] = {
+        CreateField(Layout, GridSize, false, "Benchmark Pressure 0"),
+        CreateField(Layout, GridSize, false, "Benchmark Pressure 1")};
+    Field divergence = CreateField(Layout, GridSize, false, "Benchmark Divergence");
+
+    if (!velocity[0].pResource || !velocity[1].pResource || !pressure[0].pResource || !pressure[1].pResource || !divergence.pResource)
+        return -1;
+
+    // Swirl around the grid center, written through the layout's own index so every layout does the same work
+    {
+        const Uint32 planeSize = GetFieldPlaneSize(Layout, GridSize);
+
+        std::vector<float>  bufferData(Layout == FIELD_LAYOUT_TEXTURE ? 0 : planeSize * 3, 0.f);
+        std::vector<float4> textureData(Layout == FIELD_LAYOUT_TEXTURE ? GridSize.x * GridSize.y * GridSize.z : 0);
+        for (int z = 0; z < GridSize.z; ++z)
+        {
+            for (int y = 0; y < GridSize.y; ++y)
+            {
+                for (int x = 0; x < GridSize.x; ++x)
+                {
+                    const float3 vel{static_cast<float>(GridSize.y / 2 - y), static_cast<float>(x - GridSize.x / 2), 0};
+                    if (Layout == FIELD_LAYOUT_TEXTURE)
+                    {
+                        textureData[(z * GridSize.y + y) * GridSize.x + x] = float4{vel, 1};
+                    }
+                    else
+                    {
+                        const Uint32 idx                = GetFieldIndex(Layout, GridSize, int3{x, y, z});
+                        bufferData[idx]                 = vel.x;
+                        bufferData[idx + planeSize]     = vel.y;
+                        bufferData[idx + 2 * planeSize] = vel.z;
+                    }
+                }
+            }
+        }
+
+        if (Layout == FIELD_LAYOUT_TEXTURE)
+        {
+            Box region;
+            region.MaxX = GridSize.x;
+            region.MaxY = GridSize.y;
+            region.MaxZ = GridSize.z;
+
+            TextureSubResData subresData;
+            subresData.pData       = textureData.data();
+            subresData.Stride      = sizeof(float4) * GridSize.x;
+            subresData.DepthStride = sizeof(float4) * GridSize.x * GridSize.y;
+            m_pContext->UpdateTexture(velocity[0].pResource.RawPtr<ITexture>(), 0, 0, region, subresData,
+                                      RESOURCE_STATE_TRANSITION_MODE_TRANSITION, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+        }
+        else
+        {
+            m_pContext->UpdateBuffer(velocity[0].pResource.RawPtr<IBuffer>(), 0, static_cast<Uint64>(bufferData.size() * sizeof(float)),
+                                     bufferData.data(), RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+        }
+    }
+
+    // Open domain: empty obstacle mask and no moving obstacle
+    RefCntAutoPtr<ITexture> pObstacleMask        = CreateEmptyObstacleMask(m_pDevice, GridSize, "Benchmark Obstacle Mask");
+    RefCntAutoPtr<IBuffer>  pObstacleConstantsCB = CreateNoObstacleConstants(m_pDevice, "Benchmark Obstacle Constants CB");
+
+    RefCntAutoPtr<IBuffer> pConstantsCB;
+    CreateUniformBuffer(m_pDevice, sizeof(ConstantsStruct), "Benchmark Constants CB", &pConstantsCB);
+    if (!pObstacleMask || !pObstacleConstantsCB || !pConstantsCB)
+        return -1;
+    {
+        MapHelper<ConstantsStruct> CBData(m_pContext, pConstantsCB, MAP_WRITE, MAP_FLAG_DISCARD);
+        CBData->timestep = 0.016f;
+        CBData->vec      = float3{0, 0, 0};
+    }
+
+    RefCntAutoPtr<IPipelineState> pAdvectPSO     = CreateKernel("advect.csh", Layout, EmulatedFilter, GridSize);
+    RefCntAutoPtr<IPipelineState> pForcePSO      = CreateKernel("apply_forces.csh", Layout, EmulatedFilter, GridSize);
+    RefCntAutoPtr<IPipelineState> pDivergencePSO = CreateKernel("divergence.csh", Layout, EmulatedFilter, GridSize);
+    RefCntAutoPtr<IPipelineState> pJacobiPSO     = CreateKernel("jacobi.csh", Layout, EmulatedFilter, GridSize);
+    RefCntAutoPtr<IPipelineState> pProjectPSO    = CreateKernel("project.csh", Layout, EmulatedFilter, GridSize);
+    if (!pAdvectPSO || !pForcePSO || !pDivergencePSO || !pJacobiPSO || !pProjectPSO)
+        return -1;
+
+    FluidSharedResources shared;
+    shared.pObstacleMask      = pObstacleMask;
+    shared.pObstacleConstants = pObstacleConstantsCB;
+    shared.pConstants         = pConstantsCB;
+
+    auto CreateSRB = [&](IPipelineState* pPSO, FluidBindings Bindings) {
+        return CreateFluidSRB(pPSO, shared, Bindings);
+    };
+
+    // Velocity is not swapped between steps: every step advects the same input, which keeps the work per step constant
+    auto pAdvectSRB     = CreateSRB(pAdvectPSO, {{"VelocityInSampler", velocity[0].pSRV}, {"VelocityInSampler_sampler", m_pLinearSampler}, {"VelocityOut", velocity[1].pUAV}});
+    auto pForceSRB      = CreateSRB(pForcePSO, {{"Velocity", velocity[1].pUAV}});
+    auto pDivergenceSRB = CreateSRB(pDivergencePSO, {{"VelocitySampler", velocity[1].pSRV}, {"Divergence", divergence.pUAV}});
+    auto pProjectSRB    = CreateSRB(pProjectPSO, {{"Pressure", pressure[0].pSRV}, {"Velocity", velocity[1].pUAV}});
+
+    RefCntAutoPtr<IShaderResourceBinding> pJacobiSRB[2] = {
+        CreateSRB(pJacobiPSO, {{"PressureIn", pressure[0].pSRV}, {"Divergence", divergence.pSRV}, {"PressureOut", pressure[1].pUAV}}),
+        CreateSRB(pJacobiPSO, {{"PressureIn", pressure[1].pSRV}, {"Divergence", divergence.pSRV}, {"PressureOut", pressure[0].pUAV}})};
+
+    DispatchComputeAttribs attribs;
+    attribs.ThreadGroupCountX = (GridSize.x + 7) / 8;
+    attribs.ThreadGroupCountY = (GridSize.y + 7) / 8;
+    attribs.ThreadGroupCountZ = (GridSize.z + 7) / 8;
+
+    auto Dispatch = [&](IPipelineState* pPSO, IShaderResourceBinding* pSRB) {
+        m_pContext->SetPipelineState(pPSO);
+        m_pContext->CommitShaderResources(pSRB, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+        m_pContext->DispatchCompute(attribs);
+    };
+
+    auto Step = [&]() {
+        Dispatch(pAdvectPSO, pAdvectSRB);
+        Dispatch(pForcePSO, pForceSRB);
+        Dispatch(pDivergencePSO, pDivergenceSRB);
+        for (Uint32 i = 0; i < NumJacobiIterations; ++i)
+            Dispatch(pJacobiPSO, pJacobiSRB[i & 1]);
+        Dispatch(pProjectPSO, pProjectSRB);
+    };
+
+    // Warm-up step also performs the initial resource state transitions
+    Step();
+    m_pContext->Flush();
+    m_pContext->WaitForIdle();
+
+    RefCntAutoPtr<IQuery> pQuery;
+    if (m_pDevice->GetDeviceInfo().Features.DurationQueries == DEVICE_FEATURE_STATE_ENABLED)
+    {
+        QueryDesc queryDesc;
+        queryDesc.Name = "Layout Benchmark Duration";
+        queryDesc.Type = QUERY_TYPE_DURATION;
+        m_pDevice->CreateQuery(queryDesc, &pQuery);
+    }
+
+    const auto cpuStart = std::chrono::high_resolution_clock::now();
+    if (pQuery)
+        m_pContext->BeginQuery(pQuery);
+
+    for (Uint32 step = 0; step < NumSteps; ++step)
+        Step();
+
+    if (pQuery)
+        m_pContext->EndQuery(pQuery);
+    m_pContext->Flush();
+    m_pContext->WaitForIdle();
+    const auto cpuEnd = std::chrono::high_resolution_clock::now();
+
+    // Prefer GPU time; fall back to CPU wall time around a full flush
+    double totalMs = std::chrono::duration<double, std::milli>(cpuEnd - cpuStart).count();
+    QueryDataDuration queryData;
+    if (pQuery && pQuery->GetData(&queryData, sizeof(queryData)) && queryData.Frequency != 0)
+        totalMs = static_cast<double>(queryData.Duration) / static_cast<double>(queryData.Frequency) * 1000.0;
+
+    return totalMs / std::max(NumSteps, 1u);
+}
+
+void LayoutBenchmark::Start(const std::vector<int3>& GridSizes, Uint32 NumSteps, Uint32 NumJacobiIterations)
+{
+    m_NumSteps            = NumSteps;
+    m_NumJacobiIterations = NumJacobiIterations;
+
+    m_Configs.clear();
+    m_Results.clear();
+    for (const int3& gridSize : GridSizes)
+    {
+        for (Uint32 layout = 0; layout < FIELD_LAYOUT_COUNT; ++layout)
+        {
+            // Buffer layouts always filter in the shader; the texture layout is timed with both filters
+            Result config;
+            config.GridSize       = gridSize;
+            config.Layout         = static_cast<FIELD_LAYOUT>(layout);
+            config.EmulatedFilter = config.Layout != FIELD_LAYOUT_TEXTURE;
+            m_Configs.push_back(config);
+            if (config.Layout == FIELD_LAYOUT_TEXTURE)
+            {
+                config.EmulatedFilter = true;
+                m_Configs.push_back(config);
+            }
+        }
+    }
+}
+
+void LayoutBenchmark::RunNextConfig()
+{
+    if (!IsRunning())
+        return;
+
+    Result      result   = m_Configs[m_Results.size()];
+    const int3& gridSize = result.GridSize;
+    const char* filter   = result.EmulatedFilter ? " (filtro emulado)" : "";
+    result.MsPerStep     = RunConfig(result.Layout, result.EmulatedFilter, gridSize);
+    if (result.MsPerStep < 0)
+        LOG_ERROR_MESSAGE("Benchmark: no se pudo crear la configuración ", GetFieldLayoutName(result.Layout), filter,
+                          " ", gridSize.x, "x", gridSize.y, "x", gridSize.z);
+    else
+        LOG_INFO_MESSAGE("Benchmark ", GetFieldLayoutName(result.Layout), filter, " ", gridSize.x, "x", gridSize.y, "x", gridSize.z,
+                         ": ", result.MsPerStep, " ms/step");
+    m_Results.push_back(result);
+}
+
+} // namespace Diligent
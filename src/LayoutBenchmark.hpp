@@ -0,0 +1,97 @@
+/*
+ *  Copyright 2019-2024 Diligent Graphics LLC
+ *  Copyright 2015-2019 Egor Yusov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  In no event and under no legal theory, whether in tort (including negligence),
+ *  contract, or otherwise, unless required by applicable law (such as deliberate
+ *  and grossly negligent acts) or agreed to in writing, shall any Contributor be
+ *  liable for any damages, including any direct, indirect, special, incidental,
+ *  or consequential damages of any character arising as a result of this License or
+ *  out of the use or inability to use the software (including but not limited to damages
+ *  for loss of goodwill, work stoppage, computer failure or malfunction, or any and
+ *  all other commercial damages or losses), even if such Contributor has been advised
+ *  of the possibility of such damages.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "RenderDevice.h"
+#include "DeviceContext.h"
+#include "EngineFactory.h"
+#include "RefCntAutoPtr.hpp"
+#include "FieldLayout.hpp"
+
+namespace Diligent
+{
+
+// Times one simulation step (advect, forces, divergence, jacobi iterations and project)
+// for every field layout at several grid sizes. Every configuration gets its own
+// resources and pipelines, compiled from the same kernels with different macros.
+// The texture layout runs twice: with the hardware sampler the app uses, and with the
+// manual trilinear filter of the buffer layouts, so that layouts can be compared alone.
+class LayoutBenchmark
+{
+public:
+    struct Result
+    {
+        int3         GridSize;
+        FIELD_LAYOUT Layout         = FIELD_LAYOUT_TEXTURE;
+        bool         EmulatedFilter = false; // Velocity filtered in the shader rather than by the sampler
+        double       MsPerStep      = -1;    // Negative when the configuration could not be created
+    };
+
+    LayoutBenchmark(IRenderDevice* pDevice, IDeviceContext* pContext, IEngineFactory* pEngineFactory);
+
+    // Queues all configurations and discards previous results. Nothing runs until RunNextConfig().
+    void Start(const std::vector<int3>& GridSizes, Uint32 NumSteps, Uint32 NumJacobiIterations);
+
+    // Compiles and times one queued configuration, blocking until it has finished on the GPU.
+    // Called once per frame so that a full run never stalls the app for more than one configuration.
+    void RunNextConfig();
+
+    bool   IsRunning() const { return m_Results.size() < m_Configs.size(); }
+    Uint32 GetNumConfigs() const { return static_cast<Uint32>(m_Configs.size()); }
+
+    const std::vector<Result>& GetResults() const { return m_Results; }
+
+private:
+    struct Field
+    {
+        RefCntAutoPtr<IDeviceObject> pResource;
+        IDeviceObject*               pSRV = nullptr;
+        IDeviceObject*               pUAV = nullptr;
+    };
+
+    Field CreateField(FIELD_LAYOUT Layout, const int3& GridSize, bool IsVelocity, const char* Name);
+
+    RefCntAutoPtr<IPipelineState> CreateKernel(const char* FilePath, FIELD_LAYOUT Layout, bool EmulatedFilter, const int3& GridSize);
+
+    double RunConfig(FIELD_LAYOUT Layout, bool EmulatedFilter, const int3& GridSize);
+
+    RefCntAutoPtr<IRenderDevice>                   m_pDevice;
+    RefCntAutoPtr<IDeviceContext>                  m_pContext;
+    RefCntAutoPtr<IShaderSourceInputStreamFactory> m_pShaderFactory;
+    RefCntAutoPtr<ISampler>                        m_pLinearSampler;
+
+    Uint32 m_NumSteps            = 0;
+    Uint32 m_NumJacobiIterations = 0;
+
+    std::vector<Result> m_Configs; // Queued configurations, MsPerStep unused
+    std::vector<Result> m_Results;
+};
+
+} // namespace Diligent
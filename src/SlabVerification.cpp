@@ -0,0 +1,751 @@
+/*
+ *  Copyright 2019-2024 Diligent Graphics LLC
+ *  Copyright 2015-2019 Egor Yusov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  In no event and under no legal theory, whether in tort (including negligence),
+ *  contract, or otherwise, unless required by applicable law (such as deliberate
+ *  and grossly negligent acts) or agreed to in writing, shall any Contributor be
+ *  liable for any damages, including any direct, indirect, special, incidental,
+ *  or consequential damages of any character arising as a result of this License or
+ *  out of the use or inability to use the software (including but not limited to damages
+ *  for loss of goodwill, work stoppage, computer failure or malfunction, or any and
+ *  all other commercial damages or losses), even if such Contributor has been advised
+ *  of the possibility of such damages.
+ */
+
+#include "SlabVerification.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <initializer_list>
+#include <utility>
+
+#include "Errors.hpp"
+#include "MapHelper.hpp"
+#include "ShaderMacroHelper.hpp"
+#include "GraphicsUtilities.h"
+#include "FieldLayout.hpp"
+#include "FluidConstants.hpp"
+#include "FluidKernels.hpp"
+
+#if D3D11_SUPPORTED
+#    include "EngineFactoryD3D11.h"
+#endif
+#if D3D12_SUPPORTED
+#    include "EngineFactoryD3D12.h"
+#endif
+#if VULKAN_SUPPORTED
+#    include "EngineFactoryVk.h"
+#endif
+
+namespace Diligent
+{
+
+namespace
+{
+
+// Fixed timestep, so that the decomposed and the reference runs are reproducible
+constexpr float kSlabTimeStep = 0.016f;
+
+// Swirl around the z axis that changes along z, plus a small z component. The backtrace along z stays
+// well under half a cell per step, which keeps every advection tap within the one-cell halos.
+float4 InitialVelocity(const int3& GridSize, int x, int y, int z)
+{
+    const float PI    = 3.14159265f;
+    const float swirl = 0.5f + 0.5f * std::cos(2.f * PI * static_cast<float>(z) / static_cast<float>(GridSize.z));
+    return float4{
+        static_cast<float>(GridSize.y / 2 - y) * swirl,
+        static_cast<float>(x - GridSize.x / 2) * swirl,
+        4.f * std::sin(2.f * PI * static_cast<float>(x) / static_cast<float>(GridSize.x)),
+        1.f};
+}
+
+RefCntAutoPtr<ITexture> CreateTexture3D(IRenderDevice* pDevice, const char* Name, const int3& Size, TEXTURE_FORMAT Format, USAGE Usage, const TextureData* pInitData = nullptr)
+{
+    TextureDesc texDesc;
+    texDesc.Name      = Name;
+    texDesc.Type      = RESOURCE_DIM_TEX_3D;
+    texDesc.Width     = Size.x;
+    texDesc.Height    = Size.y;
+    texDesc.Depth     = Size.z;
+    texDesc.MipLevels = 1;
+    texDesc.Usage     = Usage;
+    texDesc.Format    = Format;
+    if (Usage == USAGE_STAGING)
+        texDesc.CPUAccessFlags = CPU_ACCESS_READ;
+    else
+        texDesc.BindFlags = BIND_SHADER_RESOURCE | BIND_UNORDERED_ACCESS;
+
+    RefCntAutoPtr<ITexture> pTex;
+    pDevice->CreateTexture(texDesc, pInitData, &pTex);
+    return pTex;
+}
+
+template <typename FactoryType>
+bool FindSoftwareAdapter(FactoryType* pFactory, const Version& MinVersion, Uint32& AdapterId)
+{
+    Uint32 numAdapters = 0;
+    pFactory->EnumerateAdapters(MinVersion, numAdapters, nullptr);
+    std::vector<GraphicsAdapterInfo> adapters(numAdapters);
+    if (numAdapters > 0)
+        pFactory->EnumerateAdapters(MinVersion, numAdapters, adapters.data());
+
+    for (Uint32 i = 0; i < numAdapters; ++i)
+    {
+        if (adapters[i].Type == ADAPTER_TYPE_SOFTWARE)
+        {
+            AdapterId = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Creates a device on the software rasterizer of the same backend as the main device (WARP, lavapipe, SwiftShader)
+bool CreateSoftwareDevice(IEngineFactory* pFactory, RENDER_DEVICE_TYPE Type, IRenderDevice** ppDevice, IDeviceContext** ppContext)
+{
+    switch (Type)
+    {
+#if D3D11_SUPPORTED
+        case RENDER_DEVICE_TYPE_D3D11:
+        {
+            RefCntAutoPtr<IEngineFactoryD3D11> pFactoryD3D11{pFactory, IID_EngineFactoryD3D11};
+            EngineD3D11CreateInfo              engineCI;
+            if (!pFactoryD3D11 || !FindSoftwareAdapter(pFactoryD3D11.RawPtr(), engineCI.GraphicsAPIVersion, engineCI.AdapterId))
+                return false;
+            pFactoryD3D11->CreateDeviceAndContextsD3D11(engineCI, ppDevice, ppContext);
+            break;
+        }
+#endif
+
+#if D3D12_SUPPORTED
+        case RENDER_DEVICE_TYPE_D3D12:
+        {
+            RefCntAutoPtr<IEngineFactoryD3D12> pFactoryD3D12{pFactory, IID_EngineFactoryD3D12};
+            EngineD3D12CreateInfo              engineCI;
+            if (!pFactoryD3D12 || !FindSoftwareAdapter(pFactoryD3D12.RawPtr(), engineCI.GraphicsAPIVersion, engineCI.AdapterId))
+                return false;
+            pFactoryD3D12->CreateDeviceAndContextsD3D12(engineCI, ppDevice, ppContext);
+            break;
+        }
+#endif
+
+#if VULKAN_SUPPORTED
+        case RENDER_DEVICE_TYPE_VULKAN:
+        {
+            RefCntAutoPtr<IEngineFactoryVk> pFactoryVk{pFactory, IID_EngineFactoryVk};
+            EngineVkCreateInfo              engineCI;
+            if (!pFactoryVk || !FindSoftwareAdapter(pFactoryVk.RawPtr(), engineCI.GraphicsAPIVersion, engineCI.AdapterId))
+                return false;
+            pFactoryVk->CreateDeviceAndContextsVk(engineCI, ppDevice, ppContext);
+            break;
+        }
+#endif
+
+        default:
+            return false;
+    }
+    return *ppDevice != nullptr && *ppContext != nullptr;
+}
+
+} // namespace
+
+SlabVerification::SlabVerification(IRenderDevice* pDevice, IDeviceContext* pContext, IEngineFactory* pEngineFactory) :
+    m_pDevice{pDevice},
+    m_pContext{pContext},
+    m_pEngineFactory{pEngineFactory}
+{
+    pEngineFactory->CreateDefaultShaderSourceStreamFactory(nullptr, &m_pShaderFactory);
+}
+
+void SlabVerification::CreateDevices(const Settings& RunSettings)
+{
+    m_Devices.clear();
+
+    if (RunSettings.SoftwareDevices)
+    {
+        for (Uint32 i = 0; i < RunSettings.NumSlabs; ++i)
+        {
+            Device device;
+            if (!CreateSoftwareDevice(m_pEngineFactory, m_pDevice->GetDeviceInfo().Type, &device.pDevice, &device.pContext))
+            {
+                LOG_WARNING_MESSAGE("Slabs: no se pudo crear el dispositivo software ", i, ", se usa el dispositivo principal");
+                m_Devices.clear();
+                break;
+            }
+            m_Devices.push_back(device);
+        }
+    }
+
+    // Every slab shares the main device and context
+    if (m_Devices.empty())
+        m_Devices.push_back(Device{m_pDevice, m_pContext});
+}
+
+RefCntAutoPtr<IPipelineState> SlabVerification::CreateKernel(const Slab& slab, const char* FilePath)
+{
+    ShaderMacroHelper Macros;
+    AddFieldLayoutMacros(Macros, FIELD_LAYOUT_TEXTURE, int3{m_GridSize.x, m_GridSize.y, slab.Depth + 2 * GetHaloPlanes()});
+    if (m_RunMode == RUN_MODE_SINGLE_EMULATED)
+    {
+        // Regular kernels with the same trilinear filter as the slabs
+        Macros.AddShaderMacro("EMULATED_VELOCITY_SAMPLER", 1);
+    }
+    else if (m_RunMode == RUN_MODE_SLABS)
+    {
+        Macros.AddShaderMacro("SLAB_DECOMPOSITION", 1);
+        Macros.AddShaderMacro("SLAB_DEPTH", slab.Depth);
+        Macros.AddShaderMacro("SLAB_Z_OFFSET", slab.ZOffset);
+        Macros.AddShaderMacro("GLOBAL_SIZE_Z", m_GridSize.z);
+    }
+
+    return CreateFluidKernel(slab.pDevice, m_pShaderFactory, FilePath, Macros);
+}
+
+bool SlabVerification::CreateSlabResources(Slab& slab, bool NeedsReadback)
+{
+    const int  halo = GetHaloPlanes();
+    const int3 localSize{m_GridSize.x, m_GridSize.y, slab.Depth + 2 * halo};
+    const int3 sendSize{m_GridSize.x, m_GridSize.y, 2};
+
+    // Velocity including the halo planes, which hold the neighbouring planes of the periodic domain
+    {
+        std::vector<float4> velocityData(localSize.x * localSize.y * localSize.z);
+        for (int z = 0; z < localSize.z; ++z)
+        {
+            const int globalZ = (slab.ZOffset + z - halo + m_GridSize.z) % m_GridSize.z;
+            for (int y = 0; y < localSize.y; ++y)
+            {
+                for (int x = 0; x < localSize.x; ++x)
+                    velocityData[(z * localSize.y + y) * localSize.x + x] = InitialVelocity(m_GridSize, x, y, globalZ);
+            }
+        }
+
+        TextureSubResData subresData;
+        subresData.pData       = velocityData.data();
+        subresData.Stride      = sizeof(float4) * localSize.x;
+        subresData.DepthStride = sizeof(float4) * localSize.x * localSize.y;
+
+        TextureData initData;
+        initData.pSubResources   = &subresData;
+        initData.NumSubresources = 1;
+
+        slab.pVelocity[0] = CreateTexture3D(slab.pDevice, "Slab Velocity 0", localSize, TEX_FORMAT_RGBA32_FLOAT, USAGE_DEFAULT, &initData);
+        slab.pVelocity[1] = CreateTexture3D(slab.pDevice, "Slab Velocity 1", localSize, TEX_FORMAT_RGBA32_FLOAT, USAGE_DEFAULT, &initData);
+    }
+
+    // Pressure starts at zero, halos included; divergence is written before it is read
+    {
+        std::vector<float> pressureData(localSize.x * localSize.y * localSize.z, 0.f);
+
+        TextureSubResData subresData;
+        subresData.pData       = pressureData.data();
+        subresData.Stride      = sizeof(float) * localSize.x;
+        subresData.DepthStride = sizeof(float) * localSize.x * localSize.y;
+
+        TextureData initData;
+        initData.pSubResources   = &subresData;
+        initData.NumSubresources = 1;
+
+        slab.pPressure[0] = CreateTexture3D(slab.pDevice, "Slab Pressure 0", localSize, TEX_FORMAT_R32_FLOAT, USAGE_DEFAULT, &initData);
+        slab.pPressure[1] = CreateTexture3D(slab.pDevice, "Slab Pressure 1", localSize, TEX_FORMAT_R32_FLOAT, USAGE_DEFAULT, &initData);
+        slab.pDivergence  = CreateTexture3D(slab.pDevice, "Slab Divergence", localSize, TEX_FORMAT_R32_FLOAT, USAGE_DEFAULT);
+    }
+
+    // Open domain: empty obstacle mask and no moving obstacle
+    slab.pObstacleMask        = CreateEmptyObstacleMask(slab.pDevice, localSize, "Slab Obstacle Mask");
+    slab.pObstacleConstantsCB = CreateNoObstacleConstants(slab.pDevice, "Slab Obstacle Constants CB");
+
+    if (m_RunMode == RUN_MODE_SINGLE_SAMPLER)
+    {
+        // Same sampler as the app's advection
+        SamplerDesc SamDesc;
+        SamDesc.MinFilter = FILTER_TYPE_LINEAR;
+        SamDesc.MagFilter = FILTER_TYPE_LINEAR;
+        SamDesc.MipFilter = FILTER_TYPE_LINEAR;
+        slab.pDevice->CreateSampler(SamDesc, &slab.pLinearSampler);
+        if (!slab.pLinearSampler)
+            return false;
+    }
+
+    if (!IsSingleDomain())
+    {
+        const Uint32 zero = 0;
+
+        BufferDesc buffDesc;
+        buffDesc.Name              = "Slab Out-of-halo Taps";
+        buffDesc.Size              = sizeof(Uint32);
+        buffDesc.Usage             = USAGE_DEFAULT;
+        buffDesc.BindFlags         = BIND_UNORDERED_ACCESS;
+        buffDesc.Mode              = BUFFER_MODE_STRUCTURED;
+        buffDesc.ElementByteStride = sizeof(Uint32);
+
+        BufferData initData{&zero, sizeof(zero)};
+        slab.pDevice->CreateBuffer(buffDesc, &initData, &slab.pOutOfHaloTaps);
+        if (!slab.pOutOfHaloTaps)
+            return false;
+
+        slab.pSend[HALO_FIELD_VELOCITY] = CreateTexture3D(slab.pDevice, "Slab Velocity Send", sendSize, TEX_FORMAT_RGBA32_FLOAT, USAGE_DEFAULT);
+        slab.pSend[HALO_FIELD_PRESSURE] = CreateTexture3D(slab.pDevice, "Slab Pressure Send", sendSize, TEX_FORMAT_R32_FLOAT, USAGE_DEFAULT);
+        if (!slab.pSend[HALO_FIELD_VELOCITY] || !slab.pSend[HALO_FIELD_PRESSURE])
+            return false;
+    }
+    if (NeedsReadback)
+    {
+        slab.pReadback[HALO_FIELD_VELOCITY] = CreateTexture3D(slab.pDevice, "Slab Velocity Readback", sendSize, TEX_FORMAT_RGBA32_FLOAT, USAGE_STAGING);
+        slab.pReadback[HALO_FIELD_PRESSURE] = CreateTexture3D(slab.pDevice, "Slab Pressure Readback", sendSize, TEX_FORMAT_R32_FLOAT, USAGE_STAGING);
+
+        FenceDesc fenceDesc;
+        fenceDesc.Name = "Slab Halo Fence";
+        fenceDesc.Type = FENCE_TYPE_CPU_WAIT_ONLY;
+        slab.pDevice->CreateFence(fenceDesc, &slab.pFence);
+        if (!slab.pReadback[HALO_FIELD_VELOCITY] || !slab.pReadback[HALO_FIELD_PRESSURE] || !slab.pFence)
+            return false;
+    }
+
+    if (!slab.pVelocity[0] || !slab.pVelocity[1] || !slab.pPressure[0] || !slab.pPressure[1] || !slab.pDivergence ||
+        !slab.pObstacleMask || !slab.pObstacleConstantsCB)
+        return false;
+
+    CreateUniformBuffer(slab.pDevice, sizeof(ConstantsStruct), "Slab Constants CB", &slab.pConstantsCB);
+    CreateUniformBuffer(slab.pDevice, sizeof(SlabPassConstantsStruct), "Slab Pass CB", &slab.pSlabPassCB);
+    if (!slab.pConstantsCB || !slab.pSlabPassCB)
+        return false;
+
+    slab.pAdvectPSO     = CreateKernel(slab, "advect.csh");
+    slab.pForcePSO      = CreateKernel(slab, "apply_forces.csh");
+    slab.pDivergencePSO = CreateKernel(slab, "divergence.csh");
+    slab.pJacobiPSO     = CreateKernel(slab, "jacobi.csh");
+    slab.pProjectPSO    = CreateKernel(slab, "project.csh");
+    if (!slab.pAdvectPSO || !slab.pForcePSO || !slab.pDivergencePSO || !slab.pJacobiPSO || !slab.pProjectPSO)
+        return false;
+
+    FluidSharedResources shared;
+    shared.pObstacleMask      = slab.pObstacleMask;
+    shared.pObstacleConstants = slab.pObstacleConstantsCB;
+    shared.pConstants         = slab.pConstantsCB;
+    shared.pSlabPass          = slab.pSlabPassCB;
+
+    auto CreateSRB = [&](IPipelineState* pPSO, FluidBindings Bindings) {
+        return CreateFluidSRB(pPSO, shared, Bindings);
+    };
+
+    auto SRV = [](ITexture* pTex) -> IDeviceObject* { return pTex->GetDefaultView(TEXTURE_VIEW_SHADER_RESOURCE); };
+    auto UAV = [](ITexture* pTex) -> IDeviceObject* { return pTex->GetDefaultView(TEXTURE_VIEW_UNORDERED_ACCESS); };
+
+    IDeviceObject* pOutOfHaloTapsUAV = slab.pOutOfHaloTaps ? slab.pOutOfHaloTaps->GetDefaultView(BUFFER_VIEW_UNORDERED_ACCESS) : nullptr;
+
+    for (Uint32 i = 0; i < 2; ++i)
+    {
+        slab.pAdvectSRB[i]     = CreateSRB(slab.pAdvectPSO, {{"VelocityInSampler", SRV(slab.pVelocity[i])}, {"VelocityInSampler_sampler", slab.pLinearSampler}, {"VelocityOut", UAV(slab.pVelocity[1 - i])}, {"SlabOutOfHaloTaps", pOutOfHaloTapsUAV}});
+        slab.pForceSRB[i]      = CreateSRB(slab.pForcePSO, {{"Velocity", UAV(slab.pVelocity[i])}});
+        slab.pDivergenceSRB[i] = CreateSRB(slab.pDivergencePSO, {{"VelocitySampler", SRV(slab.pVelocity[i])}, {"Divergence", UAV(slab.pDivergence)}});
+        slab.pJacobiSRB[i]     = CreateSRB(slab.pJacobiPSO, {{"PressureIn", SRV(slab.pPressure[i])}, {"Divergence", SRV(slab.pDivergence)}, {"PressureOut", UAV(slab.pPressure[1 - i])}});
+        for (Uint32 p = 0; p < 2; ++p)
+            slab.pProjectSRB[i][p] = CreateSRB(slab.pProjectPSO, {{"Pressure", SRV(slab.pPressure[p])}, {"Velocity", UAV(slab.pVelocity[i])}});
+    }
+
+    return true;
+}
+
+bool SlabVerification::CreateSlabs(Uint32 NumSlabs, Uint32 NumDevices)
+{
+    m_Slabs.clear();
+    m_Slabs.resize(NumSlabs);
+
+    // Slabs are assigned round-robin; the first GridSize.z % NumSlabs slabs get one extra plane
+    int zOffset = 0;
+    for (Uint32 s = 0; s < NumSlabs; ++s)
+    {
+        Slab& slab    = m_Slabs[s];
+        slab.pDevice  = m_Devices[s % NumDevices].pDevice;
+        slab.pContext = m_Devices[s % NumDevices].pContext;
+        slab.Depth    = m_GridSize.z / static_cast<int>(NumSlabs) + (static_cast<int>(s) < m_GridSize.z % static_cast<int>(NumSlabs) ? 1 : 0);
+        slab.ZOffset  = zOffset;
+        zOffset += slab.Depth;
+    }
+
+    for (Uint32 s = 0; s < NumSlabs; ++s)
+    {
+        const Slab& lower = m_Slabs[(s + NumSlabs - 1) % NumSlabs];
+        const Slab& upper = m_Slabs[(s + 1) % NumSlabs];
+
+        const bool needsReadback = lower.pDevice != m_Slabs[s].pDevice || upper.pDevice != m_Slabs[s].pDevice;
+        if (!CreateSlabResources(m_Slabs[s], needsReadback))
+        {
+            LOG_ERROR_MESSAGE("Slabs: no se pudieron crear los recursos del slab ", s);
+            return false;
+        }
+    }
+    return true;
+}
+
+void SlabVerification::Dispatch(Slab& slab, IPipelineState* pPSO, IShaderResourceBinding* pSRB, SLAB_PASS Pass)
+{
+    const int numPlanes = Pass == SLAB_PASS_BOUNDARY ? 2 : (Pass == SLAB_PASS_INTERIOR ? slab.Depth - 2 : slab.Depth);
+    if (numPlanes <= 0)
+        return;
+
+    {
+        MapHelper<SlabPassConstantsStruct> PassData(slab.pContext, slab.pSlabPassCB, MAP_WRITE, MAP_FLAG_DISCARD);
+        PassData->slabPass = Pass;
+    }
+
+    DispatchComputeAttribs attribs;
+    attribs.ThreadGroupCountX = (m_GridSize.x + 7) / 8;
+    attribs.ThreadGroupCountY = (m_GridSize.y + 7) / 8;
+    attribs.ThreadGroupCountZ = (numPlanes + 7) / 8;
+
+    slab.pContext->SetPipelineState(pPSO);
+    slab.pContext->CommitShaderResources(pSRB, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+    slab.pContext->DispatchCompute(attribs);
+}
+
+void SlabVerification::SendHalos(Slab& slab, HALO_FIELD Field, Uint32 TexIdx)
+{
+    ITexture* pSrc = Field == HALO_FIELD_VELOCITY ? slab.pVelocity[TexIdx] : slab.pPressure[TexIdx];
+
+    // First interior plane goes to z = 0 of the send texture, last one to z = 1
+    for (Uint32 i = 0; i < 2; ++i)
+    {
+        Box region;
+        region.MaxX = m_GridSize.x;
+        region.MaxY = m_GridSize.y;
+        region.MinZ = i == 0 ? 1 : slab.Depth;
+        region.MaxZ = region.MinZ + 1;
+
+        CopyTextureAttribs copyAttribs;
+        copyAttribs.pSrcTexture              = pSrc;
+        copyAttribs.SrcTextureTransitionMode = RESOURCE_STATE_TRANSITION_MODE_TRANSITION;
+        copyAttribs.pSrcBox                  = &region;
+        copyAttribs.pDstTexture              = slab.pSend[Field];
+        copyAttribs.DstTextureTransitionMode = RESOURCE_STATE_TRANSITION_MODE_TRANSITION;
+        copyAttribs.DstZ                     = i;
+        slab.pContext->CopyTexture(copyAttribs);
+    }
+
+    // Neighbours on other devices read the planes back on the CPU once the fence is signaled
+    if (slab.pReadback[Field])
+    {
+        CopyTextureAttribs copyAttribs;
+        copyAttribs.pSrcTexture              = slab.pSend[Field];
+        copyAttribs.SrcTextureTransitionMode = RESOURCE_STATE_TRANSITION_MODE_TRANSITION;
+        copyAttribs.pDstTexture              = slab.pReadback[Field];
+        copyAttribs.DstTextureTransitionMode = RESOURCE_STATE_TRANSITION_MODE_TRANSITION;
+        slab.pContext->CopyTexture(copyAttribs);
+
+        slab.pContext->EnqueueSignal(slab.pFence, ++slab.FenceValue);
+    }
+
+    slab.pContext->Flush();
+}
+
+void SlabVerification::ReceiveHalos(size_t SlabIdx, HALO_FIELD Field, Uint32 TexIdx)
+{
+    const size_t numSlabs = m_Slabs.size();
+
+    Slab&       slab  = m_Slabs[SlabIdx];
+    const Slab& lower = m_Slabs[(SlabIdx + numSlabs - 1) % numSlabs];
+    const Slab& upper = m_Slabs[(SlabIdx + 1) % numSlabs];
+    ITexture*   pDst  = Field == HALO_FIELD_VELOCITY ? slab.pVelocity[TexIdx] : slab.pPressure[TexIdx];
+
+    auto FillHalo = [&](const Slab& Src, Uint32 SrcZ, Uint32 DstZ) {
+        if (Src.pDevice == slab.pDevice)
+        {
+            Box region;
+            region.MaxX = m_GridSize.x;
+            region.MaxY = m_GridSize.y;
+            region.MinZ = SrcZ;
+            region.MaxZ = SrcZ + 1;
+
+            CopyTextureAttribs copyAttribs;
+            copyAttribs.pSrcTexture              = Src.pSend[Field];
+            copyAttribs.SrcTextureTransitionMode = RESOURCE_STATE_TRANSITION_MODE_TRANSITION;
+            copyAttribs.pSrcBox                  = &region;
+            copyAttribs.pDstTexture              = pDst;
+            copyAttribs.DstTextureTransitionMode = RESOURCE_STATE_TRANSITION_MODE_TRANSITION;
+            copyAttribs.DstZ                     = DstZ;
+            slab.pContext->CopyTexture(copyAttribs);
+            return;
+        }
+
+        Src.pFence->Wait(Src.FenceValue);
+
+        MappedTextureSubresource mappedData;
+        Src.pContext->MapTextureSubresource(Src.pReadback[Field], 0, 0, MAP_READ, MAP_FLAG_NONE, nullptr, mappedData);
+        if (mappedData.pData)
+        {
+            Box region;
+            region.MaxX = m_GridSize.x;
+            region.MaxY = m_GridSize.y;
+            region.MinZ = DstZ;
+            region.MaxZ = DstZ + 1;
+
+            TextureSubResData subresData;
+            subresData.pData       = static_cast<const Uint8*>(mappedData.pData) + SrcZ * mappedData.DepthStride;
+            subresData.Stride      = mappedData.Stride;
+            subresData.DepthStride = mappedData.DepthStride;
+            slab.pContext->UpdateTexture(pDst, 0, 0, region, subresData,
+                                         RESOURCE_STATE_TRANSITION_MODE_TRANSITION, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+        }
+        Src.pContext->UnmapTextureSubresource(Src.pReadback[Field], 0, 0);
+    };
+
+    // Lower halo <- last interior plane of the lower neighbour, upper halo <- first interior plane of the upper one
+    FillHalo(lower, 1, 0);
+    FillHalo(upper, 0, slab.Depth + 1);
+}
+
+void SlabVerification::RunOverlapped(HALO_FIELD Field, Uint32 TexIdx, const std::function<void(Slab&, SLAB_PASS)>& Pass)
+{
+    // The single-domain kernels wrap along z themselves and ignore the pass
+    if (IsSingleDomain())
+    {
+        for (Slab& slab : m_Slabs)
+            Pass(slab, SLAB_PASS_ALL);
+        return;
+    }
+
+    for (Slab& slab : m_Slabs)
+    {
+        Pass(slab, SLAB_PASS_BOUNDARY);
+        SendHalos(slab, Field, TexIdx);
+    }
+
+    // Planes that do not read the halos run while the boundary planes are copied and read back
+    for (Slab& slab : m_Slabs)
+    {
+        Pass(slab, SLAB_PASS_INTERIOR);
+        slab.pContext->Flush();
+    }
+
+    for (size_t s = 0; s < m_Slabs.size(); ++s)
+        ReceiveHalos(s, Field, TexIdx);
+}
+
+void SlabVerification::Step(const Settings& RunSettings, Uint32& VelIdx, Uint32& PressureIdx)
+{
+    const Uint32 dstVelIdx = 1 - VelIdx;
+
+    for (Slab& slab : m_Slabs)
+    {
+        MapHelper<ConstantsStruct> CBData(slab.pContext, slab.pConstantsCB, MAP_WRITE, MAP_FLAG_DISCARD);
+        CBData->timestep = kSlabTimeStep;
+        CBData->vec      = float3{0, 0, 1};
+    }
+
+    // ADVECT + FORCES: forces are pointwise, so a single exchange covers both
+    RunOverlapped(HALO_FIELD_VELOCITY, dstVelIdx, [&](Slab& slab, SLAB_PASS Pass) {
+        Dispatch(slab, slab.pAdvectPSO, slab.pAdvectSRB[VelIdx], Pass);
+        Dispatch(slab, slab.pForcePSO, slab.pForceSRB[dstVelIdx], Pass);
+    });
+
+    // DIVERGENCE: read by jacobi only at the cell itself, no exchange needed
+    for (Slab& slab : m_Slabs)
+        Dispatch(slab, slab.pDivergencePSO, slab.pDivergenceSRB[dstVelIdx], SLAB_PASS_ALL);
+
+    // JACOBI: every iteration reads the neighbours' pressure, so the halos are exchanged after each one
+    for (Uint32 i = 0; i < RunSettings.NumJacobiIterations; ++i)
+    {
+        RunOverlapped(HALO_FIELD_PRESSURE, 1 - PressureIdx, [&](Slab& slab, SLAB_PASS Pass) {
+            Dispatch(slab, slab.pJacobiPSO, slab.pJacobiSRB[PressureIdx], Pass);
+        });
+        PressureIdx = 1 - PressureIdx;
+    }
+
+    // PROJECT
+    RunOverlapped(HALO_FIELD_VELOCITY, dstVelIdx, [&](Slab& slab, SLAB_PASS Pass) {
+        Dispatch(slab, slab.pProjectPSO, slab.pProjectSRB[dstVelIdx][PressureIdx], Pass);
+    });
+
+    VelIdx = dstVelIdx;
+}
+
+void SlabVerification::ReadVelocity(Uint32 VelIdx, std::vector<float4>& Velocity)
+{
+    Velocity.assign(m_GridSize.x * m_GridSize.y * m_GridSize.z, float4{});
+
+    for (Slab& slab : m_Slabs)
+    {
+        const int  halo = GetHaloPlanes();
+        const int3 localSize{m_GridSize.x, m_GridSize.y, slab.Depth + 2 * halo};
+
+        RefCntAutoPtr<ITexture> pStaging = CreateTexture3D(slab.pDevice, "Slab Velocity Staging", localSize, TEX_FORMAT_RGBA32_FLOAT, USAGE_STAGING);
+        if (!pStaging)
+            continue;
+
+        CopyTextureAttribs copyAttribs;
+        copyAttribs.pSrcTexture              = slab.pVelocity[VelIdx];
+        copyAttribs.SrcTextureTransitionMode = RESOURCE_STATE_TRANSITION_MODE_TRANSITION;
+        copyAttribs.pDstTexture              = pStaging;
+        copyAttribs.DstTextureTransitionMode = RESOURCE_STATE_TRANSITION_MODE_TRANSITION;
+        slab.pContext->CopyTexture(copyAttribs);
+        slab.pContext->WaitForIdle();
+
+        MappedTextureSubresource mappedData;
+        slab.pContext->MapTextureSubresource(pStaging, 0, 0, MAP_READ, MAP_FLAG_NONE, nullptr, mappedData);
+        if (mappedData.pData)
+        {
+            // Interior planes only
+            for (int z = 0; z < slab.Depth; ++z)
+            {
+                for (int y = 0; y < m_GridSize.y; ++y)
+                {
+                    const Uint8* pRow = static_cast<const Uint8*>(mappedData.pData) + (z + halo) * mappedData.DepthStride + y * mappedData.Stride;
+                    std::memcpy(&Velocity[((slab.ZOffset + z) * m_GridSize.y + y) * m_GridSize.x], pRow, sizeof(float4) * m_GridSize.x);
+                }
+            }
+        }
+        slab.pContext->UnmapTextureSubresource(pStaging, 0, 0);
+    }
+}
+
+Uint32 SlabVerification::ReadOutOfHaloTaps()
+{
+    Uint32 numTaps = 0;
+    for (Slab& slab : m_Slabs)
+    {
+        if (!slab.pOutOfHaloTaps)
+            continue;
+
+        BufferDesc buffDesc;
+        buffDesc.Name           = "Slab Out-of-halo Taps Staging";
+        buffDesc.Size           = sizeof(Uint32);
+        buffDesc.Usage          = USAGE_STAGING;
+        buffDesc.CPUAccessFlags = CPU_ACCESS_READ;
+
+        RefCntAutoPtr<IBuffer> pStaging;
+        slab.pDevice->CreateBuffer(buffDesc, nullptr, &pStaging);
+        if (!pStaging)
+            continue;
+
+        slab.pContext->CopyBuffer(slab.pOutOfHaloTaps, 0, RESOURCE_STATE_TRANSITION_MODE_TRANSITION,
+                                  pStaging, 0, sizeof(Uint32), RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+        slab.pContext->WaitForIdle();
+
+        MapHelper<Uint32> stagingData(slab.pContext, pStaging, MAP_READ, MAP_FLAG_NONE);
+        if (stagingData)
+            numTaps += *stagingData;
+    }
+    return numTaps;
+}
+
+double SlabVerification::Run(const Settings& RunSettings, Uint32 NumSlabs, Uint32 NumDevices, RUN_MODE Mode, std::vector<float4>& Velocity)
+{
+    m_GridSize = RunSettings.GridSize;
+    m_RunMode  = Mode;
+    if (IsSingleDomain())
+        NumSlabs = NumDevices = 1;
+    if (!CreateSlabs(NumSlabs, NumDevices))
+    {
+        m_Slabs.clear();
+        return -1;
+    }
+
+    Uint32 velIdx      = 0;
+    Uint32 pressureIdx = 0;
+
+    const auto cpuStart = std::chrono::high_resolution_clock::now();
+    for (Uint32 step = 0; step < RunSettings.NumSteps; ++step)
+        Step(RunSettings, velIdx, pressureIdx);
+    for (Slab& slab : m_Slabs)
+    {
+        slab.pContext->Flush();
+        slab.pContext->WaitForIdle();
+    }
+    const auto cpuEnd = std::chrono::high_resolution_clock::now();
+
+    ReadVelocity(velIdx, Velocity);
+    if (!IsSingleDomain())
+        m_Result.OutOfHaloTaps = ReadOutOfHaloTaps();
+    m_Slabs.clear();
+
+    return std::chrono::duration<double, std::milli>(cpuEnd - cpuStart).count() / std::max(RunSettings.NumSteps, 1u);
+}
+
+const SlabVerification::Result& SlabVerification::RunAndVerify(const Settings& RunSettings)
+{
+    m_Result = Result{};
+    if (RunSettings.NumSlabs == 0 || static_cast<int>(RunSettings.NumSlabs) > RunSettings.GridSize.z)
+    {
+        LOG_ERROR_MESSAGE("Slabs: número de slabs no válido (", RunSettings.NumSlabs, ") para una profundidad de ", RunSettings.GridSize.z);
+        return m_Result;
+    }
+
+    CreateDevices(RunSettings);
+    m_Result.NumSlabs   = RunSettings.NumSlabs;
+    m_Result.NumDevices = static_cast<Uint32>(m_Devices.size());
+
+    std::vector<float4> decomposed;
+    m_Result.MsPerStep = Run(RunSettings, RunSettings.NumSlabs, m_Result.NumDevices, RUN_MODE_SLABS, decomposed);
+
+    // Reference: the regular single-domain kernels, compiled without SLAB_DECOMPOSITION, on the device
+    // of the first slab so that both runs use the same rasterizer. Periodicity along z comes from the
+    // kernels' own wrap-around, not from the halo exchange, so bugs in the slab logic show up as mismatches.
+    std::vector<float4> reference;
+    m_Result.ReferenceMs = Run(RunSettings, 1, 1, RUN_MODE_SINGLE_EMULATED, reference);
+
+    // The same single-domain run with the hardware sampler the app uses
+    std::vector<float4> sampled;
+    const double        sampledMs = Run(RunSettings, 1, 1, RUN_MODE_SINGLE_SAMPLER, sampled);
+
+    if (m_Result.MsPerStep < 0 || m_Result.ReferenceMs < 0 || sampledMs < 0)
+    {
+        LOG_ERROR_MESSAGE("Slabs: no se pudo ejecutar la simulación descompuesta");
+        return m_Result;
+    }
+
+    // Bitwise comparison of every velocity component
+    const float* pDecomposed = &decomposed[0].x;
+    const float* pReference  = &reference[0].x;
+    for (size_t i = 0; i < decomposed.size() * 4; ++i)
+    {
+        if (std::memcmp(&pDecomposed[i], &pReference[i], sizeof(float)) != 0)
+        {
+            ++m_Result.NumMismatches;
+            m_Result.MaxAbsDiff = std::max(m_Result.MaxAbsDiff, std::abs(pDecomposed[i] - pReference[i]));
+        }
+    }
+
+    // The emulated filter only stands in for the sampler if both agree within the tolerance
+    float peakSpeed      = 0;
+    float samplerMaxDiff = 0;
+    for (size_t i = 0; i < reference.size(); ++i)
+    {
+        for (Uint32 c = 0; c < 3; ++c)
+        {
+            peakSpeed      = std::max(peakSpeed, std::abs(reference[i][c]));
+            samplerMaxDiff = std::max(samplerMaxDiff, std::abs(sampled[i][c] - reference[i][c]));
+        }
+    }
+    m_Result.SamplerRelDiff         = peakSpeed > 0 ? samplerMaxDiff / peakSpeed : samplerMaxDiff;
+    m_Result.SamplerWithinTolerance = m_Result.SamplerRelDiff <= SamplerTolerance;
+    m_Result.Valid                  = true;
+
+    if (!m_Result.SamplerWithinTolerance)
+        LOG_WARNING_MESSAGE("Slabs: el filtro emulado difiere del sampler en ", m_Result.SamplerRelDiff * 100.f,
+                            "% de la velocidad máxima (tolerancia ", SamplerTolerance * 100.f, "%)");
+    if (m_Result.OutOfHaloTaps != 0)
+        LOG_WARNING_MESSAGE("Slabs: ", m_Result.OutOfHaloTaps, " muestras de advección fuera del halo; la descomposición no es exacta");
+
+    LOG_INFO_MESSAGE("Slabs: ", m_Result.NumSlabs, " slabs en ", m_Result.NumDevices, " dispositivos, ", m_Result.MsPerStep,
+                     " ms/step (referencia ", m_Result.ReferenceMs, " ms/step), ", m_Result.NumMismatches,
+                     " diferencias, max ", m_Result.MaxAbsDiff, "; sampler vs filtro emulado ", m_Result.SamplerRelDiff * 100.f, "%");
+    return m_Result;
+}
+
+} // namespace Diligent
@@ -0,0 +1,201 @@
+/*
+ *  Copyright 2019-2024 Diligent Graphics LLC
+ *  Copyright 2015-2019 Egor Yusov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  In no event and under no legal theory, whether in tort (including negligence),
+ *  contract, or otherwise, unless required by applicable law (such as deliberate
+ *  and grossly negligent acts) or agreed to in writing, shall any Contributor be
+ *  liable for any damages, including any direct, indirect, special, incidental,
+ *  or consequential damages of any character arising as a result of this License or
+ *  out of the use or inability to use the software (including but not limited to damages
+ *  for loss of goodwill, work stoppage, computer failure or malfunction, or any and
+ *  all other commercial damages or losses), even if such Contributor has been advised
+ *  of the possibility of such damages.
+ */
+
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "RenderDevice.h"
+#include "DeviceContext.h"
+#include "EngineFactory.h"
+#include "RefCntAutoPtr.hpp"
+#include "BasicMath.hpp"
+
+namespace Diligent
+{
+
+// Verification harness for the z-slab decomposition (see slab.fxh). It does not drive the interactive
+// simulation, whose grid is a single plane: it runs its own Settings::GridSize grid, open domain with no
+// obstacles and a fixed swirl as initial velocity, and checks two things:
+//  - The decomposed run matches a single-domain run of the same kernels bitwise. The grid is split into
+//    z-slabs, each one owned by its own device and context and running the kernels compiled with
+//    SLAB_DECOMPOSITION. One-cell halos are exchanged after advect, after every pressure iteration and
+//    after project, and the exchange of the boundary planes overlaps with the interior pass of every slab.
+//    Slab kernels filter velocity in the shader (EMULATED_VELOCITY_SAMPLER), since the hardware sampler
+//    cannot address the halos, so the reference is built with the same filter.
+//  - The shader filter stays within SamplerTolerance of the hardware sampler that the app uses, by
+//    running the single-domain kernels a second time with the sampler.
+class SlabVerification
+{
+public:
+    struct Settings
+    {
+        int3   GridSize            = int3{40, 40, 32};
+        Uint32 NumSlabs            = 2;
+        Uint32 NumSteps            = 10;
+        Uint32 NumJacobiIterations = 40;
+        bool   SoftwareDevices     = true; // One software-rasterizer device per slab
+    };
+
+    struct Result
+    {
+        bool   Valid         = false;
+        Uint32 NumSlabs      = 0;
+        Uint32 NumDevices    = 0;
+        double MsPerStep     = 0;
+        double ReferenceMs   = 0; // Per step, single-domain kernels on the device of the first slab
+        Uint32 NumMismatches = 0; // Velocity components that are not bitwise identical to the reference
+        float  MaxAbsDiff    = 0;
+        Uint32 OutOfHaloTaps = 0; // Advection taps clamped to the halos; the decomposition is inexact when non-zero
+
+        // Single-domain hardware sampler run against the emulated filter of the reference, relative to its peak speed
+        float SamplerRelDiff         = 0;
+        bool  SamplerWithinTolerance = false;
+    };
+
+    // Hardware filtering uses fixed-point weights (8 fractional bits on D3D-class hardware), so the sampler
+    // differs from the float weights of the shader filter by up to 1/256 of the neighbour difference per tap.
+    // Over a few steps that stays well below 1% of the peak speed.
+    static constexpr float SamplerTolerance = 0.01f;
+
+    SlabVerification(IRenderDevice* pDevice, IDeviceContext* pContext, IEngineFactory* pEngineFactory);
+
+    // Runs the decomposed simulation, the single-domain reference (regular kernels, no halos) and the
+    // single-domain sampler run with the same settings and compares the final velocity. Blocks until all
+    // runs have finished.
+    const Result& RunAndVerify(const Settings& RunSettings);
+
+    const Result& GetResult() const { return m_Result; }
+
+private:
+    // Must match SLAB_PASS_* in slab.fxh
+    enum SLAB_PASS : Uint32
+    {
+        SLAB_PASS_ALL = 0,
+        SLAB_PASS_INTERIOR,
+        SLAB_PASS_BOUNDARY
+    };
+
+    enum RUN_MODE : Uint32
+    {
+        RUN_MODE_SLABS = 0,       // Slab kernels with halo exchange
+        RUN_MODE_SINGLE_EMULATED, // Whole domain, shader filter: the bitwise reference
+        RUN_MODE_SINGLE_SAMPLER   // Whole domain, hardware sampler as in the app
+    };
+
+    enum HALO_FIELD : Uint32
+    {
+        HALO_FIELD_VELOCITY = 0,
+        HALO_FIELD_PRESSURE,
+        HALO_FIELD_COUNT
+    };
+
+    struct Device
+    {
+        RefCntAutoPtr<IRenderDevice>  pDevice;
+        RefCntAutoPtr<IDeviceContext> pContext;
+    };
+
+    struct Slab
+    {
+        IRenderDevice*  pDevice  = nullptr;
+        IDeviceContext* pContext = nullptr;
+
+        int Depth   = 0; // Interior planes; in decomposed runs the local textures have one more plane on each side
+        int ZOffset = 0; // Global z of the first interior plane
+
+        RefCntAutoPtr<ITexture> pVelocity[2];
+        RefCntAutoPtr<ITexture> pPressure[2];
+        RefCntAutoPtr<ITexture> pDivergence;
+        RefCntAutoPtr<ITexture> pObstacleMask;
+        RefCntAutoPtr<IBuffer>  pObstacleConstantsCB;
+        RefCntAutoPtr<ISampler> pLinearSampler; // RUN_MODE_SINGLE_SAMPLER only
+
+        // First and last interior planes of each field. Neighbours on the same device copy from
+        // the send textures, neighbours on another device read them back through the staging ones.
+        RefCntAutoPtr<ITexture> pSend[HALO_FIELD_COUNT];
+        RefCntAutoPtr<ITexture> pReadback[HALO_FIELD_COUNT];
+        RefCntAutoPtr<IFence>   pFence;
+        Uint64                  FenceValue = 0;
+
+        RefCntAutoPtr<IBuffer> pConstantsCB;
+        RefCntAutoPtr<IBuffer> pSlabPassCB;
+        RefCntAutoPtr<IBuffer> pOutOfHaloTaps; // SlabOutOfHaloTaps counter in slab.fxh
+
+        RefCntAutoPtr<IPipelineState> pAdvectPSO;
+        RefCntAutoPtr<IPipelineState> pForcePSO;
+        RefCntAutoPtr<IPipelineState> pDivergencePSO;
+        RefCntAutoPtr<IPipelineState> pJacobiPSO;
+        RefCntAutoPtr<IPipelineState> pProjectPSO;
+
+        // Indexed by the velocity texture that is read (advect) or updated in place (the rest)
+        RefCntAutoPtr<IShaderResourceBinding> pAdvectSRB[2];
+        RefCntAutoPtr<IShaderResourceBinding> pForceSRB[2];
+        RefCntAutoPtr<IShaderResourceBinding> pDivergenceSRB[2];
+        RefCntAutoPtr<IShaderResourceBinding> pJacobiSRB[2];     // By input pressure texture
+        RefCntAutoPtr<IShaderResourceBinding> pProjectSRB[2][2]; // By velocity and pressure texture
+    };
+
+    void CreateDevices(const Settings& RunSettings);
+    bool CreateSlabs(Uint32 NumSlabs, Uint32 NumDevices);
+    bool CreateSlabResources(Slab& slab, bool NeedsReadback);
+
+    RefCntAutoPtr<IPipelineState> CreateKernel(const Slab& slab, const char* FilePath);
+
+    void Dispatch(Slab& slab, IPipelineState* pPSO, IShaderResourceBinding* pSRB, SLAB_PASS Pass);
+    void SendHalos(Slab& slab, HALO_FIELD Field, Uint32 TexIdx);
+    void ReceiveHalos(size_t SlabIdx, HALO_FIELD Field, Uint32 TexIdx);
+
+    // Boundary pass and send on every slab, then the interior pass while the halos are in flight
+    void RunOverlapped(HALO_FIELD Field, Uint32 TexIdx, const std::function<void(Slab&, SLAB_PASS)>& Pass);
+
+    void Step(const Settings& RunSettings, Uint32& VelIdx, Uint32& PressureIdx);
+    void   ReadVelocity(Uint32 VelIdx, std::vector<float4>& Velocity);
+    Uint32 ReadOutOfHaloTaps();
+
+    bool IsSingleDomain() const { return m_RunMode != RUN_MODE_SLABS; }
+    int  GetHaloPlanes() const { return IsSingleDomain() ? 0 : 1; }
+
+    // Returns the time per step in ms, or a negative value if the slabs could not be created.
+    // Single-domain modes run the whole grid with the regular kernels on one slab.
+    double Run(const Settings& RunSettings, Uint32 NumSlabs, Uint32 NumDevices, RUN_MODE Mode, std::vector<float4>& Velocity);
+
+    RefCntAutoPtr<IRenderDevice>                   m_pDevice;
+    RefCntAutoPtr<IDeviceContext>                  m_pContext;
+    RefCntAutoPtr<IEngineFactory>                  m_pEngineFactory;
+    RefCntAutoPtr<IShaderSourceInputStreamFactory> m_pShaderFactory;
+
+    std::vector<Device> m_Devices;
+    std::vector<Slab>   m_Slabs;
+    int3                m_GridSize;
+    RUN_MODE            m_RunMode = RUN_MODE_SLABS;
+
+    Result m_Result;
+};
+
+} // namespace Diligent
@@ -32,6 +32,11 @@
 #include "ShaderMacroHelper.hpp"
 #include "ColorConversion.h"
 #include "TextureUtilities.h"
+#include "FrameTracer.hpp"
+#include "FieldLayout.hpp"
+#include "FluidConstants.hpp"
+#include "LayoutBenchmark.hpp"
+#include "SlabVerification.hpp"
 
 namespace Diligent
 {
@@ -47,13 +52,34 @@ namespace
     const int3  kGridSize = {40,40,1};
     const float TimeStep  = 0.016f;
 
+    // Occupancy for the static obstacle presets listed in the UI
+    std::vector<Uint8> MakeObstaclePreset(int Preset)
+    {
+        std::vector<Uint8> occupancy(kGridSize.x * kGridSize.y * kGridSize.z, 0);
+        for (int z = 0; z < kGridSize.z; ++z)
+            for (int y = 0; y < kGridSize.y; ++y)
+                for (int x = 0; x < kGridSize.x; ++x)
+                {
+                    bool solid = false;
+                    if (Preset == 1)
+                    {
+                        // Two-cell thick wall across y at three quarters of the width, with a slit in the middle
+                        const int wallX = kGridSize.x * 3 / 4;
+                        solid           = (x == wallX || x == wallX + 1) && std::abs(2 * y + 1 - kGridSize.y) > kGridSize.y / 4;
+                    }
+                    else if (Preset == 2)
+                    {
+                        // Box in the center of the grid, a quarter of the width and height
+                        solid = std::abs(2 * x + 1 - kGridSize.x) < kGridSize.x / 4 &&
+                            std::abs(2 * y + 1 - kGridSize.y) < kGridSize.y / 4;
+                    }
+                    occupancy[(z * kGridSize.y + y) * kGridSize.x + x] = solid ? 1 : 0;
+                }
+        return occupancy;
+    }
+
 } // namespace
 
-struct ConstantsStruct
-{
-    float timestep;
-    float3 vec;
-};
 RefCntAutoPtr<IBuffer> m_pConstantsCB;
 
 bool m_InjectVelocity = false;
@@ -114,22 +140,49 @@ void Tutorial14_ComputeShader::CreateFluidTextures()
     m_pDevice->CreateTexture(injectDesc, nullptr, &m_pVelocityInjectStagingTex);
 }
 
+void Tutorial14_ComputeShader::CreateObstacleTextures()
+{
+    TextureDesc texDesc;
+    texDesc.Type      = RESOURCE_DIM_TEX_3D;
+    texDesc.Width     = kGridSize.x;
+    texDesc.Height    = kGridSize.y;
+    texDesc.Depth     = kGridSize.z;
+    texDesc.MipLevels = 1;
+    texDesc.Usage     = USAGE_DEFAULT;
+    texDesc.BindFlags = BIND_SHADER_RESOURCE;
+    texDesc.Format    = TEX_FORMAT_R8_UINT;
+    m_pDevice->CreateTexture(texDesc, nullptr, &m_pObstacleSourceTex);
+
+    // 32 cells along X are packed into every texel of the mask
+    texDesc.Width     = (kGridSize.x + 31) / 32;
+    texDesc.BindFlags = BIND_SHADER_RESOURCE | BIND_UNORDERED_ACCESS;
+    texDesc.Format    = TEX_FORMAT_R32_UINT;
+    m_pDevice->CreateTexture(texDesc, nullptr, &m_pObstacleStaticTex);
+    m_pDevice->CreateTexture(texDesc, nullptr, &m_pObstacleMaskTex);
+}
+
 void Tutorial14_ComputeShader::CreateFluidShaders()
 {
     const char* shaderFiles[] = {
         "advect.csh", "apply_forces.csh", "divergence.csh",
-        "jacobi.csh", "project.csh"};
+        "jacobi.csh", "project.csh", "obstacle_load.csh",
+        "obstacle_rasterize.csh"};
+
+    // The interactive simulation keeps its fields in 3D textures
+    ShaderMacroHelper Macros;
+    AddFieldLayoutMacros(Macros, FIELD_LAYOUT_TEXTURE, kGridSize);
 
     ShaderCreateInfo shaderCI;
     shaderCI.SourceLanguage                  = SHADER_SOURCE_LANGUAGE_HLSL;
     shaderCI.Desc.UseCombinedTextureSamplers = false;
+    shaderCI.Macros                          = Macros;
     RefCntAutoPtr<IShaderSourceInputStreamFactory> pShaderFactory;
     m_pEngineFactory->CreateDefaultShaderSourceStreamFactory(nullptr, &pShaderFactory);
     shaderCI.pShaderSourceStreamFactory = pShaderFactory;
 
-    const char* names[] = {"Advect", "Forces", "Divergence", "Jacobi", "Project"};
+    const char* names[] = {"Advect", "Forces", "Divergence", "Jacobi", "Project", "ObstacleLoad", "ObstacleRasterize"};
 
-    for (int i = 0; i < 5; ++i)
+    for (Uint32 i = 0; i < _countof(shaderFiles); ++i)
     {
         shaderCI.Desc.ShaderType = SHADER_TYPE_COMPUTE;
         shaderCI.EntryPoint      = "main";
@@ -156,6 +209,8 @@ void Tutorial14_ComputeShader::CreateFluidShaders()
             (i == 2) ? m_pDivergencePSO :
             (i == 3) ? m_pJacobiPSO :
             (i == 4) ? m_pProjectPSO :
+            (i == 5) ? m_pObstacleLoadPSO :
+            (i == 6) ? m_pObstacleRasterizePSO :
                        m_pAdvectPSO;
 
         m_pDevice->CreateComputePipelineState(psoCI, &pPSO);
@@ -169,7 +224,8 @@ void Tutorial14_ComputeShader::CreateFluidShaders()
 
 void Tutorial14_ComputeShader::CreateShaderResourceBindings()
 {
-    if (!m_pAdvectPSO || !m_pForcePSO || !m_pDivergencePSO || !m_pJacobiPSO || !m_pProjectPSO)
+    if (!m_pAdvectPSO || !m_pForcePSO || !m_pDivergencePSO || !m_pJacobiPSO || !m_pProjectPSO ||
+        !m_pObstacleLoadPSO || !m_pObstacleRasterizePSO)
     {
         LOG_ERROR_MESSAGE("Uno o m�s PSO no se crearon correctamente. SRBs no ser�n inicializados.");
         return;
@@ -181,8 +237,11 @@ void Tutorial14_ComputeShader::CreateShaderResourceBindings()
     m_pDivergencePSO->CreateShaderResourceBinding(&m_pDivergenceSRB, true);
     m_pJacobiPSO->CreateShaderResourceBinding(&m_pJacobiSRB, true);
     m_pProjectPSO->CreateShaderResourceBinding(&m_pProjectSRB, true);
+    m_pObstacleLoadPSO->CreateShaderResourceBinding(&m_pObstacleLoadSRB, true);
+    m_pObstacleRasterizePSO->CreateShaderResourceBinding(&m_pObstacleRasterizeSRB, true);
 
-    if (!m_pAdvectSRB || !m_pForceSRB || !m_pDivergenceSRB || !m_pJacobiSRB || !m_pProjectSRB)
+    if (!m_pAdvectSRB || !m_pForceSRB || !m_pDivergenceSRB || !m_pJacobiSRB || !m_pProjectSRB ||
+        !m_pObstacleLoadSRB || !m_pObstacleRasterizeSRB)
     {
         LOG_ERROR_MESSAGE("FIFO: Error creando SRBs.");
         return;
@@ -237,18 +296,110 @@ void Tutorial14_ComputeShader::CreateShaderResourceBindings()
 
     if (auto* var = m_pAdvectSRB->GetVariableByName(SHADER_TYPE_COMPUTE, "VelocityInSampler_sampler"))
         var->Set(pLinearSampler);
+
+    // OBSTACLES: every stencil kernel reads the packed mask
+    IShaderResourceBinding* obstacleUsers[] = {m_pAdvectSRB, m_pDivergenceSRB, m_pJacobiSRB, m_pProjectSRB};
+    for (IShaderResourceBinding* pSRB : obstacleUsers)
+    {
+        if (auto* var = pSRB->GetVariableByName(SHADER_TYPE_COMPUTE, "ObstacleMask"))
+            var->Set(m_pObstacleMaskTex->GetDefaultView(TEXTURE_VIEW_SHADER_RESOURCE));
+        if (auto* var = pSRB->GetVariableByName(SHADER_TYPE_COMPUTE, "ObstacleConstants"))
+            var->Set(m_pObstacleConstantsCB);
+    }
+
+    // OBSTACLE LOAD: Bind ObstacleSource (SRV) and ObstacleMaskOut (UAV)
+    if (auto* var = m_pObstacleLoadSRB->GetVariableByName(SHADER_TYPE_COMPUTE, "ObstacleSource"))
+        var->Set(m_pObstacleSourceTex->GetDefaultView(TEXTURE_VIEW_SHADER_RESOURCE));
+    if (auto* var = m_pObstacleLoadSRB->GetVariableByName(SHADER_TYPE_COMPUTE, "ObstacleMaskOut"))
+        var->Set(m_pObstacleStaticTex->GetDefaultView(TEXTURE_VIEW_UNORDERED_ACCESS));
+
+    // OBSTACLE RASTERIZE: Bind StaticObstacles (SRV), ObstacleMaskOut (UAV)
+    if (auto* var = m_pObstacleRasterizeSRB->GetVariableByName(SHADER_TYPE_COMPUTE, "StaticObstacles"))
+        var->Set(m_pObstacleStaticTex->GetDefaultView(TEXTURE_VIEW_SHADER_RESOURCE));
+    if (auto* var = m_pObstacleRasterizeSRB->GetVariableByName(SHADER_TYPE_COMPUTE, "ObstacleMaskOut"))
+        var->Set(m_pObstacleMaskTex->GetDefaultView(TEXTURE_VIEW_UNORDERED_ACCESS));
+    if (auto* var = m_pObstacleRasterizeSRB->GetVariableByName(SHADER_TYPE_COMPUTE, "ObstacleConstants"))
+        var->Set(m_pObstacleConstantsCB);
+}
+
+void Tutorial14_ComputeShader::LoadObstacles(const std::vector<Uint8>& Occupancy)
+{
+    if (Occupancy.size() != static_cast<size_t>(kGridSize.x * kGridSize.y * kGridSize.z))
+    {
+        LOG_ERROR_MESSAGE("Tamaño de ocupación inválido: ", Occupancy.size());
+        return;
+    }
+
+    Box region;
+    region.MaxX = kGridSize.x;
+    region.MaxY = kGridSize.y;
+    region.MaxZ = kGridSize.z;
+
+    TextureSubResData subresData;
+    subresData.pData       = Occupancy.data();
+    subresData.Stride      = kGridSize.x;
+    subresData.DepthStride = kGridSize.x * kGridSize.y;
+    m_pImmediateContext->UpdateTexture(m_pObstacleSourceTex, 0, 0, region, subresData,
+                                       RESOURCE_STATE_TRANSITION_MODE_TRANSITION, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+
+    DispatchComputeAttribs attribs;
+    attribs.ThreadGroupCountX = ((kGridSize.x + 31) / 32 + 7) / 8;
+    attribs.ThreadGroupCountY = (kGridSize.y + 7) / 8;
+    attribs.ThreadGroupCountZ = (kGridSize.z + 7) / 8;
+
+    m_pImmediateContext->SetPipelineState(m_pObstacleLoadPSO);
+    FLUID_TRACE_STALL_CALL("Commit ObstacleLoad", m_pImmediateContext->CommitShaderResources(m_pObstacleLoadSRB, RESOURCE_STATE_TRANSITION_MODE_TRANSITION));
+    m_pImmediateContext->DispatchCompute(attribs);
+}
+
+void Tutorial14_ComputeShader::RasterizeObstacles()
+{
+    {
+        FLUID_TRACE_STALL_SCOPE("Map ObstacleConstantsCB");
+        MapHelper<ObstacleConstantsStruct> CBData(m_pImmediateContext, m_pObstacleConstantsCB, MAP_WRITE, MAP_FLAG_DISCARD);
+        const float angle   = static_cast<float>(m_CurrTime) * m_ObstacleOrbitSpeed;
+        CBData->sphereCenter = float3{
+            kGridSize.x * 0.5f + m_ObstacleOrbitRadius * std::cos(angle),
+            kGridSize.y * 0.5f + m_ObstacleOrbitRadius * std::sin(angle),
+            kGridSize.z * 0.5f};
+        // Derivative of the orbit, imposed on the fluid at the sphere surface
+        CBData->sphereVelocity = float3{
+            -m_ObstacleOrbitRadius * m_ObstacleOrbitSpeed * std::sin(angle),
+            m_ObstacleOrbitRadius * m_ObstacleOrbitSpeed * std::cos(angle),
+            0};
+        CBData->sphereRadius  = m_ObstacleRadius;
+        CBData->gridSize      = uint3{static_cast<Uint32>(kGridSize.x), static_cast<Uint32>(kGridSize.y), static_cast<Uint32>(kGridSize.z)};
+        CBData->sphereEnabled = m_MovingObstacle ? 1 : 0;
+    }
+
+    DispatchComputeAttribs attribs;
+    attribs.ThreadGroupCountX = ((kGridSize.x + 31) / 32 + 7) / 8;
+    attribs.ThreadGroupCountY = (kGridSize.y + 7) / 8;
+    attribs.ThreadGroupCountZ = (kGridSize.z + 7) / 8;
+
+    m_pImmediateContext->SetPipelineState(m_pObstacleRasterizePSO);
+    FLUID_TRACE_STALL_CALL("Commit ObstacleRasterize", m_pImmediateContext->CommitShaderResources(m_pObstacleRasterizeSRB, RESOURCE_STATE_TRANSITION_MODE_TRANSITION));
+    m_pImmediateContext->DispatchCompute(attribs);
 }
 
 void Tutorial14_ComputeShader::UpdateFluidSimulation(double ElapsedTime)
 {
-    LOG_INFO_MESSAGE("UpdateFluidSimulation called, ElapsedTime = ", ElapsedTime);
+    FLUID_TRACE_SCOPE("UpdateFluidSimulation");
+    {
+        FLUID_TRACE_SCOPE("LOG_INFO_MESSAGE");
+        LOG_INFO_MESSAGE("UpdateFluidSimulation called, ElapsedTime = ", ElapsedTime);
+    }
     DispatchComputeAttribs attribs;
     attribs.ThreadGroupCountX = (kGridSize.x + 7) / 8;
     attribs.ThreadGroupCountY = (kGridSize.y + 7) / 8;
     attribs.ThreadGroupCountZ = (kGridSize.z + 7) / 8;
 
+    // OBSTACLES: static mask combined with the moving obstacle at its current position
+    RasterizeObstacles();
+
     // ADVECT
     {
+        FLUID_TRACE_STALL_SCOPE("Map ConstantsAdvectCB");
         MapHelper<ConstantsStruct> CBData(m_pImmediateContext, m_pConstantsAdvectCB, MAP_WRITE, MAP_FLAG_DISCARD);
         CBData->timestep = TimeStep * static_cast<float>(ElapsedTime);
         CBData->vec = float3{1.0f / kGridSize.x, 1.0f / kGridSize.y, 1.0f / kGridSize.z};
@@ -258,14 +409,14 @@ void Tutorial14_ComputeShader::UpdateFluidSimulation(double ElapsedTime)
         var->Set(m_pConstantsAdvectCB);
 
     m_pImmediateContext->SetPipelineState(m_pAdvectPSO);
-    m_pImmediateContext->CommitShaderResources(m_pAdvectSRB, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+    FLUID_TRACE_STALL_CALL("Commit Advect", m_pImmediateContext->CommitShaderResources(m_pAdvectSRB, RESOURCE_STATE_TRANSITION_MODE_TRANSITION));
     m_pImmediateContext->DispatchCompute(attribs);    // Inject custom velocity if requested
     if (m_InjectVelocity)
     {
         // Write to the 1x1x1 staging texture
         MappedTextureSubresource mapped;
-        m_pImmediateContext->MapTextureSubresource(
-            m_pVelocityInjectStagingTex, 0, 0, MAP_WRITE, MAP_FLAG_DISCARD, nullptr, mapped);
+        FLUID_TRACE_STALL_CALL("MapTextureSubresource Inject", m_pImmediateContext->MapTextureSubresource(
+            m_pVelocityInjectStagingTex, 0, 0, MAP_WRITE, MAP_FLAG_DISCARD, nullptr, mapped));
         if (mapped.pData)
         {        // Make sure we're using the exact values the user entered
             float* cell = reinterpret_cast<float*>(mapped.pData);
@@ -275,6 +426,7 @@ void Tutorial14_ComputeShader::UpdateFluidSimulation(double ElapsedTime)
             cell[3] = 1.0f; // Set w component to 1.0
             
             // Log what we're injecting
+            FLUID_TRACE_SCOPE("LOG_INFO_MESSAGE");
             LOG_INFO_MESSAGE("Injecting velocity: ", cell[0], ", ", cell[1], ", ", cell[2]);
         }
         m_pImmediateContext->UnmapTextureSubresource(m_pVelocityInjectStagingTex, 0, 0);
@@ -327,11 +479,12 @@ void Tutorial14_ComputeShader::UpdateFluidSimulation(double ElapsedTime)
         logCopyAttribs.DstZ = 0;
         m_pImmediateContext->CopyTexture(logCopyAttribs);
         MappedTextureSubresource mappedData;
-        m_pImmediateContext->MapTextureSubresource(
-            m_pVelocityStagingTex, 0, 0, MAP_READ, MAP_FLAG_DO_NOT_WAIT, nullptr, mappedData);
+        FLUID_TRACE_STALL_CALL("MapTextureSubresource Readback", m_pImmediateContext->MapTextureSubresource(
+            m_pVelocityStagingTex, 0, 0, MAP_READ, MAP_FLAG_DO_NOT_WAIT, nullptr, mappedData));
         if (mappedData.pData)
         {
             float* cell = reinterpret_cast<float*>(mappedData.pData);
+            FLUID_TRACE_SCOPE("LOG_INFO_MESSAGE");
             LOG_INFO_MESSAGE("[Injection] Center cell velocity: ", cell[0], ", ", cell[1], ", ", cell[2], ", ", cell[3]);
         }
         m_pImmediateContext->UnmapTextureSubresource(m_pVelocityStagingTex, 0, 0);
@@ -367,7 +520,7 @@ void Tutorial14_ComputeShader::UpdateFluidSimulation(double ElapsedTime)
 
         // Now map the staging texture
         MappedTextureSubresource mappedData;
-        m_pImmediateContext->MapTextureSubresource(
+        FLUID_TRACE_STALL_CALL("MapTextureSubresource Readback", m_pImmediateContext->MapTextureSubresource(
             m_pVelocityStagingTex, // ITexture*
             0,                     // MipLevel
             0,                     // ArraySlice
@@ -375,11 +528,12 @@ void Tutorial14_ComputeShader::UpdateFluidSimulation(double ElapsedTime)
             MAP_FLAG_DO_NOT_WAIT,  // MAP_FLAGS
             nullptr,               // Box* (null means whole subresource)
             mappedData             // MappedTextureSubresource&
-        );
+        ));
 
         if (mappedData.pData)
         {
             float* cell = reinterpret_cast<float*>(mappedData.pData);
+            FLUID_TRACE_SCOPE("LOG_INFO_MESSAGE");
             LOG_INFO_MESSAGE("Center cell velocity: ", cell[0], ", ", cell[1], ", ", cell[2], ", ", cell[3]);
         }
         m_pImmediateContext->UnmapTextureSubresource(m_pVelocityStagingTex, 0, 0);
@@ -394,11 +548,12 @@ void Tutorial14_ComputeShader::UpdateFluidSimulation(double ElapsedTime)
         copyAttribs.DstY = 0;
         copyAttribs.DstZ = 0;
         m_pImmediateContext->CopyTexture(copyAttribs);
-        m_pImmediateContext->MapTextureSubresource(
-            m_pVelocityStagingTex, 0, 0, MAP_READ, MAP_FLAG_DO_NOT_WAIT, nullptr, mappedData);
+        FLUID_TRACE_STALL_CALL("MapTextureSubresource Readback", m_pImmediateContext->MapTextureSubresource(
+            m_pVelocityStagingTex, 0, 0, MAP_READ, MAP_FLAG_DO_NOT_WAIT, nullptr, mappedData));
         if (mappedData.pData)
         {
             float* cell = reinterpret_cast<float*>(mappedData.pData);
+            FLUID_TRACE_SCOPE("LOG_INFO_MESSAGE");
             LOG_INFO_MESSAGE("Edge cell velocity: ", cell[0], ", ", cell[1], ", ", cell[2], ", ", cell[3]);
         }
         m_pImmediateContext->UnmapTextureSubresource(m_pVelocityStagingTex, 0, 0);
@@ -426,6 +581,7 @@ void Tutorial14_ComputeShader::UpdateFluidSimulation(double ElapsedTime)
 
     // FORCES
     {
+        FLUID_TRACE_STALL_SCOPE("Map ConstantsForcesCB");
         MapHelper<ConstantsStruct> CBData(m_pImmediateContext, m_pConstantsForcesCB, MAP_WRITE, MAP_FLAG_DISCARD);
         CBData->timestep = TimeStep * static_cast<float>(ElapsedTime);
         CBData->vec = float3{0.0f, 0.0f, 0.0f};
@@ -433,23 +589,23 @@ void Tutorial14_ComputeShader::UpdateFluidSimulation(double ElapsedTime)
     if (auto* var = m_pForceSRB->GetVariableByName(SHADER_TYPE_COMPUTE, "Constants"))
         var->Set(m_pConstantsForcesCB);
     m_pImmediateContext->SetPipelineState(m_pForcePSO);
-    m_pImmediateContext->CommitShaderResources(m_pForceSRB, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+    FLUID_TRACE_STALL_CALL("Commit Force", m_pImmediateContext->CommitShaderResources(m_pForceSRB, RESOURCE_STATE_TRANSITION_MODE_TRANSITION));
     m_pImmediateContext->DispatchCompute(attribs);
 
 
     m_pImmediateContext->SetPipelineState(m_pDivergencePSO);
-    m_pImmediateContext->CommitShaderResources(m_pDivergenceSRB, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+    FLUID_TRACE_STALL_CALL("Commit Divergence", m_pImmediateContext->CommitShaderResources(m_pDivergenceSRB, RESOURCE_STATE_TRANSITION_MODE_TRANSITION));
     m_pImmediateContext->DispatchCompute(attribs);
 
     for (int i = 0; i < 40; ++i)
     {
         m_pImmediateContext->SetPipelineState(m_pJacobiPSO);
-        m_pImmediateContext->CommitShaderResources(m_pJacobiSRB, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+        FLUID_TRACE_STALL_CALL("Commit Jacobi", m_pImmediateContext->CommitShaderResources(m_pJacobiSRB, RESOURCE_STATE_TRANSITION_MODE_TRANSITION));
         m_pImmediateContext->DispatchCompute(attribs);
     }
 
     m_pImmediateContext->SetPipelineState(m_pProjectPSO);
-    m_pImmediateContext->CommitShaderResources(m_pProjectSRB, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+    FLUID_TRACE_STALL_CALL("Commit Project", m_pImmediateContext->CommitShaderResources(m_pProjectSRB, RESOURCE_STATE_TRANSITION_MODE_TRANSITION));
     m_pImmediateContext->DispatchCompute(attribs);
 
     std::swap(m_pPressureTex[0], m_pPressureTex[1]);
@@ -521,6 +677,7 @@ void Tutorial14_ComputeShader::CreateRenderVolumePSO()
     m_pDevice->CreateGraphicsPipelineState(PSOCreateInfo, &m_pRenderVolumePSO);
 
     if (m_pRenderVolumePSO)
+    {
         m_pRenderVolumePSO->CreateShaderResourceBinding(&m_pRenderVolumeSRB, true);
         
         if (auto* var = m_pRenderVolumeSRB->GetVariableByName(SHADER_TYPE_PIXEL, "sampLinear"))
@@ -533,10 +690,143 @@ void Tutorial14_ComputeShader::CreateRenderVolumePSO()
             m_pDevice->CreateSampler(SamDesc, &pSampler);
             var->Set(pSampler);
         }
+
+        if (auto* var = m_pRenderVolumeSRB->GetVariableByName(SHADER_TYPE_PIXEL, "ObstacleMask"))
+            var->Set(m_pObstacleMaskTex->GetDefaultView(TEXTURE_VIEW_SHADER_RESOURCE));
+    }
     else
         LOG_ERROR_MESSAGE("FIFO: Error creando el PSO de renderizado de volumen.");
 }
 
+void Tutorial14_ComputeShader::CreateRenderSlicePSO()
+{
+    GraphicsPipelineStateCreateInfo PSOCreateInfo;
+
+    PipelineResourceLayoutDesc Layout;
+    Layout.DefaultVariableType = SHADER_RESOURCE_VARIABLE_TYPE_MUTABLE;
+
+    ShaderResourceVariableDesc Vars[] = {
+        {SHADER_TYPE_PIXEL, "VolumeTex", SHADER_RESOURCE_VARIABLE_TYPE_DYNAMIC}
+    };
+    Layout.Variables    = Vars;
+    Layout.NumVariables = _countof(Vars);
+
+    PSOCreateInfo.PSODesc.ResourceLayout = Layout;
+
+    PSOCreateInfo.PSODesc.PipelineType              = PIPELINE_TYPE_GRAPHICS;
+    PSOCreateInfo.PSODesc.Name                      = "Render Slice PSO";
+    PSOCreateInfo.GraphicsPipeline.NumRenderTargets = 1;
+    PSOCreateInfo.GraphicsPipeline.RTVFormats[0]    = m_pSwapChain->GetDesc().ColorBufferFormat;
+    PSOCreateInfo.GraphicsPipeline.DSVFormat        = m_pSwapChain->GetDesc().DepthBufferFormat;
+
+    // El corte es opaco: sin blending ni depth test
+    PSOCreateInfo.GraphicsPipeline.PrimitiveTopology            = PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    PSOCreateInfo.GraphicsPipeline.DepthStencilDesc.DepthEnable = false;
+
+    ShaderCreateInfo ShaderCI;
+    ShaderCI.SourceLanguage = SHADER_SOURCE_LANGUAGE_HLSL;
+    RefCntAutoPtr<IShaderSourceInputStreamFactory> pShaderFactory;
+    m_pEngineFactory->CreateDefaultShaderSourceStreamFactory(nullptr, &pShaderFactory);
+    ShaderCI.pShaderSourceStreamFactory = pShaderFactory;
+    ShaderCI.EntryPoint                 = "main";
+
+    RefCntAutoPtr<IShader> pVS, pPS;
+
+    // Reuse the fullscreen quad of the volume renderer
+    ShaderCI.Desc.ShaderType = SHADER_TYPE_VERTEX;
+    ShaderCI.Desc.Name       = "Slice VS";
+    ShaderCI.FilePath        = "volume.vsh";
+    m_pDevice->CreateShader(ShaderCI, &pVS);
+
+    ShaderCI.Desc.ShaderType = SHADER_TYPE_PIXEL;
+    ShaderCI.Desc.Name       = "Slice PS";
+    ShaderCI.FilePath        = "slice.psh";
+    m_pDevice->CreateShader(ShaderCI, &pPS);
+
+    PSOCreateInfo.pVS = pVS;
+    PSOCreateInfo.pPS = pPS;
+
+    m_pDevice->CreateGraphicsPipelineState(PSOCreateInfo, &m_pRenderSlicePSO);
+    if (!m_pRenderSlicePSO)
+    {
+        LOG_ERROR_MESSAGE("FIFO: Error creando el PSO de renderizado de cortes.");
+        return;
+    }
+
+    m_pRenderSlicePSO->CreateShaderResourceBinding(&m_pRenderSliceSRB, true);
+
+    if (auto* var = m_pRenderSliceSRB->GetVariableByName(SHADER_TYPE_PIXEL, "sampLinear"))
+    {
+        SamplerDesc SamDesc;
+        SamDesc.MinFilter = FILTER_TYPE_LINEAR;
+        SamDesc.MagFilter = FILTER_TYPE_LINEAR;
+        SamDesc.MipFilter = FILTER_TYPE_LINEAR;
+        RefCntAutoPtr<ISampler> pSampler;
+        m_pDevice->CreateSampler(SamDesc, &pSampler);
+        var->Set(pSampler);
+    }
+    if (auto* var = m_pRenderSliceSRB->GetVariableByName(SHADER_TYPE_PIXEL, "ColorMapLUT"))
+        var->Set(m_pColorMapTex->GetDefaultView(TEXTURE_VIEW_SHADER_RESOURCE));
+    if (auto* var = m_pRenderSliceSRB->GetVariableByName(SHADER_TYPE_PIXEL, "ObstacleMask"))
+        var->Set(m_pObstacleMaskTex->GetDefaultView(TEXTURE_VIEW_SHADER_RESOURCE));
+    if (auto* var = m_pRenderSliceSRB->GetVariableByName(SHADER_TYPE_PIXEL, "SliceConstants"))
+        var->Set(m_pSliceConstantsCB);
+}
+
+void Tutorial14_ComputeShader::CreateColorMapLUT()
+{
+    constexpr Uint32 LUTSize = 256;
+
+    // Piecewise-linear colour maps: velocity magnitude and signed pressure
+    const float4 velocityStops[] = {
+        float4{0.00f, 0.00f, 0.00f, 1}, float4{0.10f, 0.15f, 0.60f, 1}, float4{0.00f, 0.70f, 0.90f, 1},
+        float4{0.95f, 0.90f, 0.20f, 1}, float4{1.00f, 1.00f, 1.00f, 1}};
+    const float4 pressureStops[] = {
+        float4{0.10f, 0.20f, 0.80f, 1}, float4{1.00f, 1.00f, 1.00f, 1}, float4{0.80f, 0.10f, 0.10f, 1}};
+
+    auto Evaluate = [](const float4* stops, Uint32 numStops, float t) {
+        const float x  = t * static_cast<float>(numStops - 1);
+        const Uint32 i = std::min(static_cast<Uint32>(x), numStops - 2);
+        return lerp(stops[i], stops[i + 1], x - static_cast<float>(i));
+    };
+
+    std::vector<Uint8> lutData(LUTSize * 2 * 4);
+    for (Uint32 row = 0; row < 2; ++row)
+    {
+        for (Uint32 i = 0; i < LUTSize; ++i)
+        {
+            const float  t   = static_cast<float>(i) / static_cast<float>(LUTSize - 1);
+            const float4 col = row == 0 ?
+                Evaluate(velocityStops, _countof(velocityStops), t) :
+                Evaluate(pressureStops, _countof(pressureStops), t);
+
+            Uint8* texel = &lutData[(row * LUTSize + i) * 4];
+            for (Uint32 c = 0; c < 4; ++c)
+                texel[c] = static_cast<Uint8>(clamp(col[c], 0.f, 1.f) * 255.f + 0.5f);
+        }
+    }
+
+    TextureDesc texDesc;
+    texDesc.Name      = "Color Map LUT";
+    texDesc.Type      = RESOURCE_DIM_TEX_2D;
+    texDesc.Width     = LUTSize;
+    texDesc.Height    = 2;
+    texDesc.MipLevels = 1;
+    texDesc.Usage     = USAGE_IMMUTABLE;
+    texDesc.BindFlags = BIND_SHADER_RESOURCE;
+    texDesc.Format    = TEX_FORMAT_RGBA8_UNORM;
+
+    TextureSubResData subresData;
+    subresData.pData  = lutData.data();
+    subresData.Stride = LUTSize * 4;
+
+    TextureData initData;
+    initData.pSubResources   = &subresData;
+    initData.NumSubresources = 1;
+
+    m_pDevice->CreateTexture(texDesc, &initData, &m_pColorMapTex);
+}
+
 void Tutorial14_ComputeShader::CreateConsantBuffer()
 {
     BufferDesc CBDesc;
@@ -550,6 +840,14 @@ void Tutorial14_ComputeShader::CreateConsantBuffer()
 
     CBDesc.Name = "Constants Forces CB";
     m_pDevice->CreateBuffer(CBDesc, nullptr, &m_pConstantsForcesCB);
+
+    CBDesc.Name = "Obstacle Constants CB";
+    CBDesc.Size = sizeof(ObstacleConstantsStruct);
+    m_pDevice->CreateBuffer(CBDesc, nullptr, &m_pObstacleConstantsCB);
+
+    CBDesc.Name = "Slice Constants CB";
+    CBDesc.Size = sizeof(SliceConstantsStruct);
+    m_pDevice->CreateBuffer(CBDesc, nullptr, &m_pSliceConstantsCB);
 }
 
 
@@ -559,9 +857,16 @@ void Tutorial14_ComputeShader::Initialize(const SampleInitInfo& InitInfo)
     
     CreateConsantBuffer();
     CreateFluidTextures();
+    CreateObstacleTextures();
     CreateFluidShaders();
     CreateShaderResourceBindings();
     CreateRenderVolumePSO();
+    CreateColorMapLUT();
+    CreateRenderSlicePSO();
+
+    // Open box by default; scenes provide their own occupancy through LoadObstacles()
+    LoadObstacles(MakeObstaclePreset(m_ObstaclePreset));
+    RasterizeObstacles();
 }
 
 void Tutorial14_ComputeShader::RenderUI()
@@ -616,6 +921,118 @@ void Tutorial14_ComputeShader::RenderUI()
     ImGui::Text("Visualization:");
     const char* visModes[] = { "Velocity", "Pressure" };
     ImGui::Combo("Mode", &m_VisualizationMode, visModes, IM_ARRAYSIZE(visModes));
+
+    // Single-slice grids always use the slice view
+    if (kGridSize.z > 1)
+    {
+        ImGui::Checkbox("Slice View", &m_SliceView);
+        if (m_SliceView)
+        {
+            const char* axes[] = {"X", "Y", "Z"};
+            ImGui::Combo("Slice Axis", &m_SliceAxis, axes, IM_ARRAYSIZE(axes));
+            const int axisSize = m_SliceAxis == 0 ? kGridSize.x : m_SliceAxis == 1 ? kGridSize.y : kGridSize.z;
+            m_SliceIndex       = std::min(m_SliceIndex, axisSize - 1);
+            ImGui::SliderInt("Slice", &m_SliceIndex, 0, axisSize - 1);
+        }
+    }
+    if (m_SliceView || kGridSize.z == 1)
+        ImGui::SliderFloat("Color Scale", &m_SliceValueScale, 0.1f, 200.0f, "%.1f", ImGuiSliderFlags_Logarithmic);
+
+    ImGui::Separator();
+    ImGui::Text("Obstacles:");
+    const char* obstaclePresets[] = {"None", "Wall", "Box"};
+    if (ImGui::Combo("Static Obstacles", &m_ObstaclePreset, obstaclePresets, IM_ARRAYSIZE(obstaclePresets)))
+        m_ObstaclePresetChanged = true;
+    ImGui::Checkbox("Moving Obstacle", &m_MovingObstacle);
+    ImGui::SliderFloat("Radius", &m_ObstacleRadius, 1.0f, 10.0f);
+    ImGui::SliderFloat("Orbit Radius", &m_ObstacleOrbitRadius, 0.0f, 20.0f);
+    ImGui::SliderFloat("Orbit Speed", &m_ObstacleOrbitSpeed, -5.0f, 5.0f);
+
+#if FLUID_ENABLE_TRACING
+    ImGui::Separator();
+    ImGui::Text("CPU Tracing:");
+    FrameTracer& tracer = FrameTracer::Get();
+
+    bool tracingEnabled = tracer.IsEnabled();
+    if (ImGui::Checkbox("Enabled", &tracingEnabled))
+        tracer.SetEnabled(tracingEnabled);
+
+    float stallThreshold = tracer.GetStallThresholdMs();
+    if (ImGui::SliderFloat("Stall Threshold (ms)", &stallThreshold, 0.1f, 16.0f))
+        tracer.SetStallThresholdMs(stallThreshold);
+
+    ImGui::PlotHistogram("Frame Time (1 ms bins)", tracer.GetHistogram(), FrameTracer::NumHistogramBins,
+                         0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 80));
+    ImGui::Text("Last frame: %.2f ms", tracer.GetLastFrameMs());
+    ImGui::Text("Tracer overhead: %.3f ms (%.2f%%)", tracer.GetLastOverheadMs(),
+                tracer.GetLastFrameMs() > 0 ? 100.0f * tracer.GetLastOverheadMs() / tracer.GetLastFrameMs() : 0.0f);
+    ImGui::Text("Stalls: %u (last: %s)", tracer.GetStallCount(),
+                tracer.GetLastStallName() != nullptr ? tracer.GetLastStallName() : "-");
+
+    if (ImGui::Button("Export Chrome Trace"))
+    {
+        if (tracer.ExportChromeTrace("fluid_trace.json"))
+            LOG_INFO_MESSAGE("Traza exportada a fluid_trace.json");
+        else
+            LOG_ERROR_MESSAGE("Error exportando la traza");
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Reset Stats"))
+        tracer.ResetStatistics();
+#endif
+
+    ImGui::Separator();
+    ImGui::Text("Field Layout Benchmark:");
+    // Runs from Update(), one configuration per frame, outside of the frame's render work
+    const bool benchmarkRunning = m_pLayoutBenchmark && m_pLayoutBenchmark->IsRunning();
+    if (benchmarkRunning)
+        ImGui::Text("Running %u/%u...", static_cast<Uint32>(m_pLayoutBenchmark->GetResults().size()) + 1, m_pLayoutBenchmark->GetNumConfigs());
+    else if (ImGui::Button("Run Benchmark"))
+        m_LayoutBenchmarkRequested = true;
+    if (m_pLayoutBenchmark)
+    {
+        for (const LayoutBenchmark::Result& result : m_pLayoutBenchmark->GetResults())
+        {
+            // "hw" filters velocity with the texture sampler, "emu" with the shader code of the buffer layouts
+            const char* filter = result.EmulatedFilter ? "emu" : "hw";
+            if (result.MsPerStep < 0)
+                ImGui::Text("%3dx%3dx%3d  %-10s %-3s  error", result.GridSize.x, result.GridSize.y, result.GridSize.z,
+                            GetFieldLayoutName(result.Layout), filter);
+            else
+                ImGui::Text("%3dx%3dx%3d  %-10s %-3s  %8.3f ms/step", result.GridSize.x, result.GridSize.y, result.GridSize.z,
+                            GetFieldLayoutName(result.Layout), filter, result.MsPerStep);
+        }
+    }
+
+    ImGui::Separator();
+    ImGui::Text("Slab Decomposition Check:");
+    const int3 slabGridSize = SlabVerification::Settings{}.GridSize;
+    ImGui::TextDisabled("Own %dx%dx%d open grid, independent of the simulation above", slabGridSize.x, slabGridSize.y, slabGridSize.z);
+    ImGui::SliderInt("Slabs", &m_NumSlabs, 1, 8);
+    ImGui::Checkbox("Software Devices", &m_SlabSoftwareDevices);
+    if (ImGui::Button("Run & Verify"))
+        m_SlabRunRequested = true;
+    if (m_pSlabVerification)
+    {
+        const SlabVerification::Result& result = m_pSlabVerification->GetResult();
+        if (!result.Valid)
+        {
+            ImGui::Text("error");
+        }
+        else
+        {
+            ImGui::Text("%u slabs, %u devices: %.3f ms/step (single %.3f ms/step)", result.NumSlabs, result.NumDevices,
+                        result.MsPerStep, result.ReferenceMs);
+            if (result.NumMismatches == 0)
+                ImGui::Text("Identical to the single-domain run");
+            else
+                ImGui::Text("%u mismatches, max diff %g", result.NumMismatches, result.MaxAbsDiff);
+            if (result.OutOfHaloTaps != 0)
+                ImGui::Text("%u advection taps beyond the halos", result.OutOfHaloTaps);
+            ImGui::Text("Hardware sampler vs emulated filter: %.3f%% (%s)", result.SamplerRelDiff * 100.f,
+                        result.SamplerWithinTolerance ? "within tolerance" : "out of tolerance");
+        }
+    }
     
     ImGui::End();
 }
@@ -648,11 +1065,52 @@ void Tutorial14_ComputeShader::RenderVolume()
         m_pImmediateContext->TransitionResourceStates(1, &transitionDesc);
     }
 
+    StateTransitionDesc obstacleTransitionDesc(
+        m_pObstacleMaskTex,
+        RESOURCE_STATE_UNKNOWN,
+        RESOURCE_STATE_SHADER_RESOURCE,
+        STATE_TRANSITION_FLAG_UPDATE_STATE
+    );
+    m_pImmediateContext->TransitionResourceStates(1, &obstacleTransitionDesc);
+
+    // A one-slice grid is a 2D image: colour-map it directly instead of raymarching
+    if (m_pRenderSlicePSO && (kGridSize.z == 1 || m_SliceView))
+    {
+        RenderSlice(pSRV);
+        return;
+    }
+
     if (auto* var = m_pRenderVolumeSRB->GetVariableByName(SHADER_TYPE_PIXEL, "VolumeTex"))
         var->Set(pSRV);
 
     m_pImmediateContext->SetPipelineState(m_pRenderVolumePSO);
-    m_pImmediateContext->CommitShaderResources(m_pRenderVolumeSRB, RESOURCE_STATE_TRANSITION_MODE_VERIFY);
+    FLUID_TRACE_STALL_CALL("Commit RenderVolume", m_pImmediateContext->CommitShaderResources(m_pRenderVolumeSRB, RESOURCE_STATE_TRANSITION_MODE_VERIFY));
+
+    DrawAttribs DrawAttrs;
+    DrawAttrs.NumVertices = 6; // Fullscreen quad
+    DrawAttrs.Flags       = DRAW_FLAG_VERIFY_ALL;
+    m_pImmediateContext->Draw(DrawAttrs);
+}
+
+void Tutorial14_ComputeShader::RenderSlice(ITextureView* pSRV)
+{
+    {
+        const int axis     = kGridSize.z == 1 ? 2 : m_SliceAxis;
+        const int axisSize = axis == 0 ? kGridSize.x : axis == 1 ? kGridSize.y : kGridSize.z;
+
+        FLUID_TRACE_STALL_SCOPE("Map SliceConstantsCB");
+        MapHelper<SliceConstantsStruct> CBData(m_pImmediateContext, m_pSliceConstantsCB, MAP_WRITE, MAP_FLAG_DISCARD);
+        CBData->sliceAxis  = static_cast<Uint32>(axis);
+        CBData->slicePos   = (static_cast<float>(std::min(m_SliceIndex, axisSize - 1)) + 0.5f) / static_cast<float>(axisSize);
+        CBData->visMode    = static_cast<Uint32>(m_VisualizationMode);
+        CBData->valueScale = m_SliceValueScale;
+    }
+
+    if (auto* var = m_pRenderSliceSRB->GetVariableByName(SHADER_TYPE_PIXEL, "VolumeTex"))
+        var->Set(pSRV);
+
+    m_pImmediateContext->SetPipelineState(m_pRenderSlicePSO);
+    FLUID_TRACE_STALL_CALL("Commit RenderSlice", m_pImmediateContext->CommitShaderResources(m_pRenderSliceSRB, RESOURCE_STATE_TRANSITION_MODE_TRANSITION));
 
     DrawAttribs DrawAttrs;
     DrawAttrs.NumVertices = 6; // Fullscreen quad
@@ -663,6 +1121,8 @@ void Tutorial14_ComputeShader::RenderVolume()
 // Render a frame
 void Tutorial14_ComputeShader::Render()
 {
+    FLUID_TRACE_SCOPE("Render");
+
     ITextureView* pRTV = m_pSwapChain->GetCurrentBackBufferRTV();
     ITextureView* pDSV = m_pSwapChain->GetDepthBufferDSV();
     float4        ClearColor = {1.0f, 1.0f, 1.0f, 1.0f};
@@ -676,7 +1136,46 @@ void Tutorial14_ComputeShader::Render()
 
 void Tutorial14_ComputeShader::Update(double CurrTime, double ElapsedTime)
 {
+#if FLUID_ENABLE_TRACING
+    FrameTracer::Get().BeginFrame();
+#endif
+    FLUID_TRACE_SCOPE("Update");
+
     SampleBase::Update(CurrTime, ElapsedTime);
+    m_CurrTime = CurrTime;
+
+    if (m_LayoutBenchmarkRequested)
+    {
+        m_LayoutBenchmarkRequested = false;
+        if (!m_pLayoutBenchmark)
+            m_pLayoutBenchmark.reset(new LayoutBenchmark{m_pDevice, m_pImmediateContext, m_pEngineFactory});
+
+        const std::vector<int3> gridSizes = {kGridSize, int3{32, 32, 32}, int3{64, 64, 64}, int3{128, 128, 128}};
+        m_pLayoutBenchmark->Start(gridSizes, 10, 40);
+    }
+    else if (m_pLayoutBenchmark && m_pLayoutBenchmark->IsRunning())
+    {
+        m_pLayoutBenchmark->RunNextConfig();
+    }
+
+    if (m_SlabRunRequested)
+    {
+        m_SlabRunRequested = false;
+        if (!m_pSlabVerification)
+            m_pSlabVerification.reset(new SlabVerification{m_pDevice, m_pImmediateContext, m_pEngineFactory});
+
+        // Depth 1 has nothing to split, so the decomposed mode runs on its own 3D grid
+        SlabVerification::Settings settings;
+        settings.NumSlabs        = static_cast<Uint32>(m_NumSlabs);
+        settings.SoftwareDevices = m_SlabSoftwareDevices;
+        m_pSlabVerification->RunAndVerify(settings);
+    }
+
+    if (m_ObstaclePresetChanged)
+    {
+        m_ObstaclePresetChanged = false;
+        LoadObstacles(MakeObstaclePreset(m_ObstaclePreset));
+    }
 
     UpdateFluidSimulation(ElapsedTime);
 
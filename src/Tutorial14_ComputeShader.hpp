@@ -27,6 +27,9 @@
 
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include "SampleBase.hpp"
 #include "ResourceMapping.h"
 #include "BasicMath.hpp"
@@ -34,6 +37,9 @@
 namespace Diligent
 {
 
+class LayoutBenchmark;
+class SlabVerification;
+
 class Tutorial14_ComputeShader final : public SampleBase
 {
 public:
@@ -44,14 +50,23 @@ public:
 
     virtual const Char* GetSampleName() const override final { return "Tutorial14: Compute Shader"; }
 
+    // Replaces the static obstacles. Occupancy has one byte per cell of the simulation grid,
+    // x-major then y then z, non-zero meaning solid. The moving obstacle is added on top every step.
+    void LoadObstacles(const std::vector<Uint8>& Occupancy);
+
 private:
     void CreateFluidTextures();
     void CreateFluidShaders();
     void CreateShaderResourceBindings();
     void UpdateFluidSimulation(double ElapsedTime);
     void RenderVolume();
+    void RenderSlice(ITextureView* pSRV);
     void CreateConsantBuffer();
     void CreateRenderVolumePSO();
+    void CreateObstacleTextures();
+    void RasterizeObstacles();
+    void CreateRenderSlicePSO();
+    void CreateColorMapLUT();
 
     int m_ThreadGroupSize = 256;
     int3 m_GridSize       = {32, 32, 32};
@@ -62,26 +77,67 @@ private:
     RefCntAutoPtr<ITexture> m_pPressureTex[2];
     RefCntAutoPtr<ITexture> m_pDivergenceTex;
 
+    // Obstacles: one byte per cell source volume, packed into 32 cells per R32_UINT texel
+    RefCntAutoPtr<ITexture> m_pObstacleSourceTex;
+    RefCntAutoPtr<ITexture> m_pObstacleStaticTex;
+    RefCntAutoPtr<ITexture> m_pObstacleMaskTex;
+
     RefCntAutoPtr<IPipelineState> m_pAdvectPSO;
     RefCntAutoPtr<IPipelineState> m_pForcePSO;
     RefCntAutoPtr<IPipelineState> m_pDivergencePSO;
     RefCntAutoPtr<IPipelineState> m_pJacobiPSO;
     RefCntAutoPtr<IPipelineState> m_pProjectPSO;
+    RefCntAutoPtr<IPipelineState> m_pObstacleLoadPSO;
+    RefCntAutoPtr<IPipelineState> m_pObstacleRasterizePSO;
 
     RefCntAutoPtr<IShaderResourceBinding> m_pAdvectSRB;
     RefCntAutoPtr<IShaderResourceBinding> m_pForceSRB;
     RefCntAutoPtr<IShaderResourceBinding> m_pDivergenceSRB;
     RefCntAutoPtr<IShaderResourceBinding> m_pJacobiSRB;
     RefCntAutoPtr<IShaderResourceBinding> m_pProjectSRB;
+    RefCntAutoPtr<IShaderResourceBinding> m_pObstacleLoadSRB;
+    RefCntAutoPtr<IShaderResourceBinding> m_pObstacleRasterizeSRB;
 
     RefCntAutoPtr<IPipelineState>         m_pRenderVolumePSO;
     RefCntAutoPtr<IShaderResourceBinding> m_pRenderVolumeSRB;
 
+    // Direct colour-mapped slice view, used for single-slice grids
+    RefCntAutoPtr<IPipelineState>         m_pRenderSlicePSO;
+    RefCntAutoPtr<IShaderResourceBinding> m_pRenderSliceSRB;
+    RefCntAutoPtr<ITexture>               m_pColorMapTex;
+
     RefCntAutoPtr<IBuffer> m_pConstantsAdvectCB;
     RefCntAutoPtr<IBuffer> m_pConstantsForcesCB;
+    RefCntAutoPtr<IBuffer> m_pObstacleConstantsCB;
+    RefCntAutoPtr<IBuffer> m_pSliceConstantsCB;
 
     bool m_InjectVelocity = false;
     float4 m_CustomVelocity = float4{0, 100, 0, 1};
+
+    // Moving sphere obstacle orbiting the grid center (sizes in cells)
+    bool   m_MovingObstacle      = false;
+    float  m_ObstacleRadius      = 3.0f;
+    float  m_ObstacleOrbitRadius = 10.0f;
+    float  m_ObstacleOrbitSpeed  = 1.0f;
+    double m_CurrTime            = 0;
+
+    // Static obstacle preset loaded through LoadObstacles(): 0 = none, 1 = wall, 2 = box
+    int  m_ObstaclePreset        = 0;
+    bool m_ObstaclePresetChanged = false;
+
+    bool  m_SliceView       = false;
+    int   m_SliceAxis       = 2;
+    int   m_SliceIndex      = 0;
+    float m_SliceValueScale = 100.0f;
+
+    std::unique_ptr<LayoutBenchmark> m_pLayoutBenchmark;
+    bool                             m_LayoutBenchmarkRequested = false;
+
+    int  m_NumSlabs            = 2;
+    bool m_SlabSoftwareDevices = true;
+    bool m_SlabRunRequested    = false;
+
+    std::unique_ptr<SlabVerification> m_pSlabVerification;
     void RenderUI();
 };
 